@@ -17,33 +17,40 @@
  **************************************************************/
 
 RGBWWLed::RGBWWLed() {
-	_isAnimationActive = false;
-	_cancelAnimation = false;
-	_clearAnimationQueue = false;
 	_current_color = HSVCT(0, 0, 0);
 	_current_output = ChannelOutput(0, 0, 0, 0, 0);
-	_currentAnimation = NULL;
-	_animationQ = new RGBWWLedAnimationQ(RGBWW_ANIMATIONQSIZE);
-	_pwm_output = NULL;
+	_output = NULL;
+	_ownsOutput = false;
+	for (int i = 0; i < RGBWW_CHANNELS::NUM_CHANNELS; i++) {
+		_frames[0][i] = 0;
+		_frames[1][i] = 0;
+	}
+	_frontFrame = 0;
 
-	last_active = 0;
+#if RGBWW_DITHER_BITS > 0
+	_last_dither = 0;
+#endif
 
 }
 
 RGBWWLed::~RGBWWLed() {
-	delete _animationQ;
-	if (_currentAnimation != NULL) {
-		delete _currentAnimation;
-	}
-	if (_pwm_output != NULL) {
-		delete _pwm_output;
-	}
+	cleanupOutput();
 
 }
 
 
+#if defined(RGBWW_USE_ESP_HWPWM) || defined(RGBWW_USE_ARDUINO_PWM)
 void RGBWWLed::init(int redPIN, int greenPIN, int bluePIN, int wwPIN, int cwPIN, int pwmFrequency /* =200 */) {
-	_pwm_output = new PWMOutput(redPIN, greenPIN, bluePIN, wwPIN, cwPIN, pwmFrequency);
+	cleanupOutput();
+	_output = new PWMOutput(redPIN, greenPIN, bluePIN, wwPIN, cwPIN, pwmFrequency);
+	_ownsOutput = true;
+}
+#endif
+
+
+void RGBWWLed::init(RGBWWOutput* output) {
+	cleanupOutput();
+	_output = output;
 }
 
 
@@ -69,41 +76,112 @@ HSVCT RGBWWLed::getCurrentColor() {
 
 
 void RGBWWLed::setOutput(HSVCT& outputcolor) {
-	RGBWCT rgbwk;
+	ChannelOutput output;
 	_current_color = outputcolor;
-	colorutils.HSVtoRGB(outputcolor, rgbwk);
-	setOutput(rgbwk);
+	colorutils.HSVtoOutput(outputcolor, output);
+	setOutput(output);
 
 }
 
 
 void RGBWWLed::setOutput(RGBWCT& outputcolor) {
 	ChannelOutput output;
+	RGBWW_PROFILE_BEGIN(PROFILE_WHITEBALANCE);
 	colorutils.whiteBalance(outputcolor, output);
+	RGBWW_PROFILE_END(PROFILE_WHITEBALANCE);
 	setOutput(output);
 }
 
 
 void RGBWWLed::setOutput(ChannelOutput& output) {
-	if(_pwm_output != NULL) {
+	if(_output != NULL) {
+		RGBWW_PROFILE_BEGIN(PROFILE_BRIGHTNESS);
+		colorutils.calibrate(output);
 		colorutils.correctBrightness(output);
+		RGBWW_PROFILE_END(PROFILE_BRIGHTNESS);
 		_current_output = output;
-		debugRGBW("R:%i | G:%i | B:%i | WW:%i | CW:%i", output.r, output.g, output.b, output.ww, output.cw);
-		_pwm_output->setOutput(RGBWW_dim_curve[output.r],
-							   RGBWW_dim_curve[output.g],
-							   RGBWW_dim_curve[output.b],
-							   RGBWW_dim_curve[output.ww],
-							   RGBWW_dim_curve[output.cw]);
+		traceRGBW(TRACE_OUTPUT, output.r, output.g, output.b, output.ww, output.cw);
+		RGBWW_PROFILE_BEGIN(PROFILE_DIMCURVE);
+#if RGBWW_DITHER_BITS > 0
+		int duty[RGBWW_CHANNELS::NUM_CHANNELS];
+#else
+		int* duty = backFrame();
+#endif
+		duty[RGBWW_CHANNELS::RED] = RGBWW_dim_curve[output.r];
+		duty[RGBWW_CHANNELS::GREEN] = RGBWW_dim_curve[output.g];
+		duty[RGBWW_CHANNELS::BLUE] = RGBWW_dim_curve[output.b];
+		duty[RGBWW_CHANNELS::WW] = RGBWW_dim_curve[output.ww];
+		duty[RGBWW_CHANNELS::CW] = RGBWW_dim_curve[output.cw];
+		powerlimiter.limit(duty, RGBWW_DIM_CURVE_MAXVAL);
+		RGBWW_PROFILE_END(PROFILE_DIMCURVE);
+#if RGBWW_DITHER_BITS > 0
+		_dither.setOutput(duty[RGBWW_CHANNELS::RED],
+						  duty[RGBWW_CHANNELS::GREEN],
+						  duty[RGBWW_CHANNELS::BLUE],
+						  duty[RGBWW_CHANNELS::WW],
+						  duty[RGBWW_CHANNELS::CW]);
+		ditherOutput();
+#else
+		commitFrame();
+#endif
 	}
 };
 
 void RGBWWLed::setOutputRaw(int& red, int& green, int& blue, int& wwhite, int& cwhite) {
-	if(_pwm_output != NULL) {
+	if(_output != NULL) {
 		_current_output = ChannelOutput(red, green, blue, wwhite, cwhite);
-		_pwm_output->setOutput(red, green, blue, wwhite, cwhite);
+#if RGBWW_DITHER_BITS > 0
+		// raw values are whole pwm duties - only the fraction left
+		// by the power limiter is dithered
+		int duty[RGBWW_CHANNELS::NUM_CHANNELS];
+		duty[RGBWW_CHANNELS::RED] = red << RGBWW_DITHER_BITS;
+		duty[RGBWW_CHANNELS::GREEN] = green << RGBWW_DITHER_BITS;
+		duty[RGBWW_CHANNELS::BLUE] = blue << RGBWW_DITHER_BITS;
+		duty[RGBWW_CHANNELS::WW] = wwhite << RGBWW_DITHER_BITS;
+		duty[RGBWW_CHANNELS::CW] = cwhite << RGBWW_DITHER_BITS;
+		powerlimiter.limit(duty, RGBWW_DIM_CURVE_MAXVAL);
+		_dither.setOutput(duty[RGBWW_CHANNELS::RED],
+						  duty[RGBWW_CHANNELS::GREEN],
+						  duty[RGBWW_CHANNELS::BLUE],
+						  duty[RGBWW_CHANNELS::WW],
+						  duty[RGBWW_CHANNELS::CW]);
+		ditherOutput();
+#else
+		int* duty = backFrame();
+		duty[RGBWW_CHANNELS::RED] = red;
+		duty[RGBWW_CHANNELS::GREEN] = green;
+		duty[RGBWW_CHANNELS::BLUE] = blue;
+		duty[RGBWW_CHANNELS::WW] = wwhite;
+		duty[RGBWW_CHANNELS::CW] = cwhite;
+		powerlimiter.limit(duty, RGBWW_PWMMAXVAL);
+		commitFrame();
+#endif
 	}
 }
 
+#if RGBWW_DITHER_BITS > 0
+void RGBWWLed::ditherOutput() {
+	_dither.nextFrame(backFrame());
+	commitFrame();
+}
+#endif
+
+const int* RGBWWLed::getOutputFrame() {
+	return _frames[_frontFrame];
+}
+
+void RGBWWLed::commitFrame() {
+	// swapping the index publishes the complete frame at once
+	_frontFrame ^= 1;
+	const int* duty = _frames[_frontFrame];
+	RGBWW_PROFILE_SCOPE(PROFILE_OUTPUT);
+	_output->setOutput(duty[RGBWW_CHANNELS::RED],
+						   duty[RGBWW_CHANNELS::GREEN],
+						   duty[RGBWW_CHANNELS::BLUE],
+						   duty[RGBWW_CHANNELS::WW],
+						   duty[RGBWW_CHANNELS::CW]);
+}
+
 
 /**************************************************************
  *                 ANIMATION/TRANSITION
@@ -112,47 +190,29 @@ void RGBWWLed::setOutputRaw(int& red, int& green, int& blue, int& wwhite, int& c
 
 bool RGBWWLed::show() {
 
-
-	// check if we need to cancel effect
-	if (_cancelAnimation || _clearAnimationQueue) {
-
-		if (_cancelAnimation ) {
-			cleanupCurrentAnimation();
-		}
-
-		// cleanup Q if we cancel all effects
-		if (_clearAnimationQueue) {
-			cleanupAnimationQ();
-		}
-	}
-
-	#ifdef ARDUINO
-		//only need this part when using arduino
-		long now = millis();
-		if (now - last_active < RGBWW_MINTIMEDIFF) {
-			// Interval hasn't passed yet
-			return true;
+	#if RGBWW_DITHER_BITS > 0
+		// advance the dithered output independent of the animation frames
+		if (_output != NULL && millis() - _last_dither >= RGBWW_DITHER_MINTIMEDIFF) {
+			_last_dither = millis();
+			if (_dither.isActive()) {
+				ditherOutput();
+			}
 		}
-		last_active = now;
-	#endif // ARDUINO
+	#endif
 
-	// Interval has passed
 	// check if we need to animate or there is any new animation
-	if (!_isAnimationActive) {
-		//check if animation otherwise return true
-		if (_animationQ->isEmpty()) {
-			return true;
-		}
-		_currentAnimation = _animationQ->pop();
-		_isAnimationActive = true;
+	RGBWWLedAnimation* animation = _animations.nextFrame();
+	if (animation == NULL) {
+		return true;
 	}
 
-	if (_currentAnimation->run()) {
+	RGBWW_PROFILE_SCOPE(PROFILE_FRAME);
+	if (animation->run()) {
 		//callback animation finished
 		if(_animationcallback != NULL ){
 			_animationcallback(this);
 		}
-		cleanupCurrentAnimation();
+		_animations.finish();
 	}
 
 	return false;
@@ -160,30 +220,38 @@ bool RGBWWLed::show() {
 }
 
 
+RGBWWFrameStats RGBWWLed::getFrameStats() {
+	return _animations.getFrameStats();
+}
+
+
+void RGBWWLed::resetFrameStats() {
+	_animations.resetFrameStats();
+}
+
+
 bool RGBWWLed::addToQueue(RGBWWLedAnimation* animation) {
-	return _animationQ->push(animation);
+	return _animations.push(animation);
 }
 
 
 bool RGBWWLed::isAnimationQFull() {
-	return _animationQ->isFull();
+	return _animations.isFull();
 }
 
 
 bool RGBWWLed::isAnimationActive() {
-	return _isAnimationActive;
+	return _animations.isActive();
 }
 
 
 void RGBWWLed::skipAnimation(){
-	if (_isAnimationActive) {
-		_cancelAnimation = true;
-	}
+	_animations.skip();
 }
 
 
 void RGBWWLed::clearAnimationQueue() {
-	_clearAnimationQueue = true;
+	_animations.clear();
 }
 
 
@@ -193,25 +261,26 @@ void RGBWWLed::setAnimationCallback( void (*func)(RGBWWLed* led) ) {
 
 
 void RGBWWLed::setAnimationSpeed(int speed) {
-	if(_currentAnimation != NULL) {
-		_currentAnimation->setSpeed(speed);
+	RGBWWLedAnimation* animation = _animations.getCurrent();
+	if(animation != NULL) {
+		animation->setSpeed(speed);
 	}
 }
 
 
 void RGBWWLed::setAnimationBrightness(int brightness){
-	if(_currentAnimation != NULL) {
-			_currentAnimation->setBrightness(brightness);
-		}
+	RGBWWLedAnimation* animation = _animations.getCurrent();
+	if(animation != NULL) {
+		animation->setBrightness(brightness);
+	}
 }
 
 void RGBWWLed::setHSV(HSVCT& color, bool queue /*= false */) {
 	if (!queue) {
 		//not using queue
-		cleanupAnimationQ();
-		cleanupCurrentAnimation();
+		_animations.stop();
 	}
-	_animationQ->push(new HSVSetOutput(color, this));
+	_animations.push(new HSVSetOutput(color, this));
 }
 
 
@@ -219,10 +288,9 @@ void RGBWWLed::setHSV(HSVCT& color, bool queue /*= false */) {
 void RGBWWLed::setHSV(HSVCT& color, int time, bool  queue /*= false*/) {
 	if (!queue) {
 		//not using queue
-		cleanupAnimationQ();
-		cleanupCurrentAnimation();
+		_animations.stop();
 	}
-	_animationQ->push(new HSVSetOutput(color, this, time));
+	_animations.push(new HSVSetOutput(color, this, time));
 }
 
 
@@ -242,17 +310,15 @@ void RGBWWLed::fadeHSV(HSVCT& color, int time, int direction /* = 1 */, bool que
 		// no animation - setting color directly
 		if (!queue) {
 			//not using queue
-			cleanupAnimationQ();
-			cleanupCurrentAnimation();
+			_animations.stop();
 		}
-		_animationQ->push(new HSVSetOutput(color, this));
+		_animations.push(new HSVSetOutput(color, this));
 	} else {
 		if (!queue) {
 			//not using queue
-			cleanupAnimationQ();
-			cleanupCurrentAnimation();
+			_animations.stop();
 		}
-		_animationQ->push(new HSVTransition(color, time, direction, this));
+		_animations.push(new HSVTransition(color, time, direction, this));
 	}
 
 }
@@ -265,18 +331,16 @@ void RGBWWLed::fadeHSV(HSVCT& colorFrom, HSVCT& color, int time, int direction /
 			// no animation - setting color directly
 			if (!queue) {
 				//not using queue
-				cleanupAnimationQ();
-				cleanupCurrentAnimation();
+				_animations.stop();
 			}
-			_animationQ->push(new HSVSetOutput(color, this));
+			_animations.push(new HSVSetOutput(color, this));
 
 		} else {
 			if (!queue) {
 				//not using queue
-				cleanupAnimationQ();
-				cleanupCurrentAnimation();
+				_animations.stop();
 			}
-			_animationQ->push(new HSVTransition(colorFrom, color, time, direction, this));
+			_animations.push(new HSVTransition(colorFrom, color, time, direction, this));
 
 		}
 	}
@@ -286,77 +350,66 @@ void RGBWWLed::fadeHSV(HSVCT& colorFrom, HSVCT& color, int time, int direction /
 void RGBWWLed::setRAW(ChannelOutput output, bool queue /* = false */) {
 	if (!queue) {
 		//not using queue
-		cleanupAnimationQ();
-		cleanupCurrentAnimation();
+		_animations.stop();
 	}
-	_animationQ->push(new RAWSetOutput(output, this));
+	_animations.push(new RAWSetOutput(output, this));
 
 }
 
 void RGBWWLed::setRAW(ChannelOutput output, int time, bool queue /* = false */) {
 	if (!queue) {
 		//not using queue
-		cleanupAnimationQ();
-		cleanupCurrentAnimation();
+		_animations.stop();
 	}
-	_animationQ->push(new RAWSetOutput(output, this, time));
+	_animations.push(new RAWSetOutput(output, this, time));
 }
 
 
-void RGBWWLed::fadeRAW(ChannelOutput output, int time, bool queue /* = false */) {
+void RGBWWLed::fadeRAW(ChannelOutput output, int time, bool queue /* = false */, bool mired /* = false */) {
 	if (time == 0 || time < RGBWW_MINTIMEDIFF) {
 		// no animation - setting color directly
 		if (!queue) {
 			//not using queue
-			cleanupAnimationQ();
-			cleanupCurrentAnimation();
+			_animations.stop();
 		}
-		_animationQ->push(new RAWSetOutput(output, this));
+		_animations.push(new RAWSetOutput(output, this));
 	} else {
 		if (!queue) {
 			//not using queue
-			cleanupAnimationQ();
-			cleanupCurrentAnimation();
+			_animations.stop();
 		}
-		_animationQ->push(new RAWTransition(output, time, this));
+		_animations.push(new RAWTransition(output, time, this, mired));
 	}
 }
 
 
-void RGBWWLed::fadeRAW(ChannelOutput output_from, ChannelOutput output, int time, bool queue /* = false */) {
+void RGBWWLed::fadeRAW(ChannelOutput output_from, ChannelOutput output, int time, bool queue /* = false */, bool mired /* = false */) {
 	if (output_from.r != output.r || output_from.g != output.g || output_from.b != output.b  ||
 				output_from.ww != output.ww || output_from.cw != output.cw ) {
 		if (time == 0 || time < RGBWW_MINTIMEDIFF) {
 			// no animation - setting color directly
 			if (!queue) {
 				//not using queue
-				cleanupAnimationQ();
-				cleanupCurrentAnimation();
+				_animations.stop();
 			}
-			_animationQ->push(new RAWSetOutput(output, this));
+			_animations.push(new RAWSetOutput(output, this));
 
 		} else {
 			if (!queue) {
 				//not using queue
-				cleanupAnimationQ();
-				cleanupCurrentAnimation();
+				_animations.stop();
 			}
-			_animationQ->push(new RAWTransition(output_from, output, time, this));
+			_animations.push(new RAWTransition(output_from, output, time, this, mired));
 
 		}
 	}
 }
 
 
-void RGBWWLed::cleanupCurrentAnimation() {
-	if (_currentAnimation != NULL) {
-		_isAnimationActive = false;
-		delete _currentAnimation;
-		_currentAnimation = NULL;
+void RGBWWLed::cleanupOutput() {
+	if (_ownsOutput) {
+		delete _output;
 	}
-}
-
-void RGBWWLed::cleanupAnimationQ() {
-	_animationQ->clear();
-	_clearAnimationQueue = false;
+	_output = NULL;
+	_ownsOutput = false;
 }
@@ -39,31 +39,80 @@
 #ifdef SMING_VERSION
 	#define RGBWW_USE_ESP_HWPWM
 	#include "../../SmingCore/SmingCore.h"
-	#define RGBWW_PWMRESOLUTION 65536
-	#define RGBWW_CALC_DEPTH 10
+	#ifndef RGBWW_PWMRESOLUTION
+		#define RGBWW_PWMRESOLUTION 65536
+	#endif
+	#ifndef RGBWW_CALC_DEPTH
+		#define RGBWW_CALC_DEPTH 10
+	#endif
 #else
-	#define RGBWW_PWMRESOLUTION 1023
-	#define RGBWW_CALC_DEPTH 8
+	#ifdef ARDUINO
+		#define RGBWW_USE_ARDUINO_PWM
+	#endif
+	// without Arduino (i.e. host builds) no pwm backend is available
+	// and an output has to be provided with RGBWWLed::init(RGBWWOutput*)
+	#ifndef RGBWW_PWMRESOLUTION
+		#define RGBWW_PWMRESOLUTION 1024
+	#endif
+	#ifndef RGBWW_CALC_DEPTH
+		#define RGBWW_CALC_DEPTH 8
+	#endif
 #endif
 
 #define RGBWW_VERSION "0.8.1"
-#define RGBWW_CALC_WIDTH int(pow(2, RGBWW_CALC_DEPTH))
-#define	RGBWW_CALC_MAXVAL int(RGBWW_CALC_WIDTH - 1)
-#define	RGBWW_CALC_HUEWHEELMAX int(RGBWW_CALC_MAXVAL * 6)
+#define RGBWW_CALC_WIDTH (1 << RGBWW_CALC_DEPTH)
+#define	RGBWW_CALC_MAXVAL (RGBWW_CALC_WIDTH - 1)
+#define	RGBWW_CALC_HUEWHEELMAX (RGBWW_CALC_MAXVAL * 6)
+#define RGBWW_PWMMAXVAL (RGBWW_PWMRESOLUTION - 1)
+
+static_assert(RGBWW_CALC_DEPTH >= 8 && RGBWW_CALC_DEPTH <= 16, "RGBWW_CALC_DEPTH needs to be in [8, 16]");
+
+// integer type for products of two calc values (or a value and a hue)
+// 32bit is sufficient up to a calc depth of 14bit
+#if RGBWW_CALC_DEPTH > 14
+	#define RGBWW_CALC_WIDE int64_t
+#else
+	#define RGBWW_CALC_WIDE int32_t
+#endif
+
+// temporal dithering - number of additional bits gained
+// below the pwm resolution (0 = disabled)
+#ifndef RGBWW_DITHER_BITS
+	#define RGBWW_DITHER_BITS 0
+#endif
+#define RGBWW_DITHER_UPDATEFREQUENCY 200
+#define RGBWW_DITHER_MINTIMEDIFF (1000 / RGBWW_DITHER_UPDATEFREQUENCY)
 
 
 #define RGBWW_UPDATEFREQUENCY 50
-#define RGBWW_MINTIMEDIFF  int(1000 / RGBWW_UPDATEFREQUENCY)
+#define RGBWW_MINTIMEDIFF  (1000 / RGBWW_UPDATEFREQUENCY)
 #define RGBWW_ANIMATIONQSIZE 100
 #define	RGBWW_WARMWHITEKELVIN 2700
 #define RGBWW_COLDWHITEKELVIN 6000
 
+// frame interval histogram - buckets of 1/4 RGBWW_MINTIMEDIFF,
+// the last bucket holds all longer intervals
+#ifndef RGBWW_FRAMESTATS_BUCKETS
+	#define RGBWW_FRAMESTATS_BUCKETS 12
+#endif
+// frames exceeding RGBWW_MINTIMEDIFF by more than this (us) are late
+#ifndef RGBWW_FRAMESTATS_TOLERANCE
+	#define RGBWW_FRAMESTATS_TOLERANCE (RGBWW_MINTIMEDIFF * 1000L / 4)
+#endif
+// skip show() calls within RGBWW_MINTIMEDIFF - arduino calls show() from
+// loop() as often as possible, other platforms from a timer
+#if defined(ARDUINO) && !defined(RGBWW_FRAME_GATE)
+	#define RGBWW_FRAME_GATE
+#endif
+
 
 #ifndef DEBUG_RGBWW
 	#define DEBUG_RGBWW 0
 #endif
 
 #include "debugUtils.h"
+#include "RGBWWLedProfile.h"
+#include "RGBWWLedTrace.h"
 #include "RGBWWconst.h"
 #include "RGBWWLedColor.h"
 #include "RGBWWLedAnimation.h"
@@ -74,7 +123,8 @@
 class RGBWWLedAnimation;
 class RGBWWLedAnimationQ;
 class RGBWWColorUtils;
-class PWMOutput;
+class RGBWWOutput;
+
 
 /**
  *
@@ -84,7 +134,7 @@ class RGBWWLed
 public:
 
 	RGBWWLed();
-	~RGBWWLed();
+	virtual ~RGBWWLed();
 
 	/**
 	 * Initialize the the LED Controller
@@ -96,13 +146,28 @@ public:
 	 * @param cwPIN		int representing the MC pin for the cold white channel
 	 * @param pwmFrequency (default 200)
 	 */
+#if defined(RGBWW_USE_ESP_HWPWM) || defined(RGBWW_USE_ARDUINO_PWM)
 	void init(int redPIN, int greenPIN, int bluePIN, int wwPIN, int cwPIN, int pwmFrequency=200);
+#endif
+
+
+	/**
+	 * Initialize the LED Controller with an output backend
+	 * The backend is not deleted by the controller
+	 *
+	 * @param output	output backend receiving the channel duties
+	 */
+	void init(RGBWWOutput* output);
 
 
 	/**
 	 * Main function for processing animations/color output
 	 * Use this in your loop()
 	 *
+	 * When temporal dithering is enabled (RGBWW_DITHER_BITS > 0)
+	 * the dithered output is also advanced here, so show() should
+	 * be called at least every RGBWW_DITHER_MINTIMEDIFF ms
+	 *
 	 *
 	 * @retval true 	not updating
 	 * @retval false 	updates applied
@@ -125,7 +190,7 @@ public:
 	 *
 	 * @param HSVK&	outputcolor
 	 */
-	void setOutput(HSVCT& color);
+	virtual void setOutput(HSVCT& color);
 
 
 	/**
@@ -134,11 +199,11 @@ public:
 	 *
 	 * @param RGBWK& outputcolor
 	 */
-	void setOutput(RGBWCT& color);
+	virtual void setOutput(RGBWCT& color);
 
 	/**
 	 * Sets the output of the controller to the specified
-	 * channel values (with internal brightness correction)
+	 * channel values (with internal calibration and brightness correction)
 	 */
 	void setOutput(ChannelOutput& output);
 
@@ -146,6 +211,11 @@ public:
 	/**
 	 * Directly set the PWM values without color correction or white balance.
 	 * Assumes the values are in the range of [0, PWMMAXVAL].
+	 * The power budget (powerlimiter) still applies.
+	 *
+	 * Raw values are whole pwm duties and gain no resolution from
+	 * temporal dithering - only the fraction of a duty left by the
+	 * power limiter is dithered.
 	 *
 	 * @param int&	red
 	 * @param int&	green
@@ -170,6 +240,16 @@ public:
 	 */
 	ChannelOutput getCurrentOutput();
 
+	/**
+	 * Returns the duties of the last frame committed to the output
+	 *
+	 * The frame is double buffered and always complete, the
+	 * next frame is prepared in a separate buffer
+	 *
+	 * @return const int*	array of RGBWW_CHANNELS::NUM_CHANNELS duties
+	 */
+	const int* getOutputFrame();
+
 
 	/**
 	 * 	Output specified color
@@ -259,8 +339,9 @@ public:
 	 * @param output
 	 * @param time
 	 * @param queue
+	 * @param mired		fade ww/cw in mired if only ww/cw change (see RAWTransition)
 	 */
-	void fadeRAW(ChannelOutput output, int time, bool queue = false );
+	void fadeRAW(ChannelOutput output, int time, bool queue = false, bool mired = false);
 
 
 	//TODO: add documentation
@@ -270,8 +351,9 @@ public:
 	 * @param output
 	 * @param time
 	 * @param queue
+	 * @param mired		fade ww/cw in mired if only ww/cw change (see RAWTransition)
 	 */
-	void fadeRAW(ChannelOutput output_from, ChannelOutput output, int time, bool queue = false );
+	void fadeRAW(ChannelOutput output_from, ChannelOutput output, int time, bool queue = false, bool mired = false);
 
 	/**
 	 * Set a function as callback when an animation has finished.
@@ -338,28 +420,102 @@ public:
 	 */
 	bool addToQueue(RGBWWLedAnimation* animation);
 
+	/**
+	 * Returns the frame timing statistics
+	 *
+	 * @return RGBWWFrameStats
+	 */
+	RGBWWFrameStats getFrameStats();
+
+	/**
+	 * Reset the frame timing statistics
+	 *
+	 */
+	void	resetFrameStats();
+
 	//colorutils
 	RGBWWColorUtils colorutils;
 
+	//power budget of the output
+	RGBWWPowerLimiter powerlimiter;
 
-private:
-	unsigned long last_active;
-	ChannelOutput  _current_output;
+
+protected:
 	HSVCT 	_current_color;
-	bool    _cancelAnimation;
-	bool    _clearAnimationQueue;
-	bool    _isAnimationActive;
 
-	RGBWWLedAnimation*  _currentAnimation;
-	RGBWWLedAnimationQ* _animationQ;
-	PWMOutput* _pwm_output;
+private:
+	ChannelOutput  _current_output;
+	RGBWWAnimationPlayer _animations;
+	RGBWWOutput* _output;
+	bool	_ownsOutput;
+
+	// double buffered output frames (duties of all channels) - the
+	// pipeline fills the back frame which is committed as a whole
+	int		_frames[2][RGBWW_CHANNELS::NUM_CHANNELS];
+	volatile uint8_t _frontFrame;
+
+	int*	backFrame() { return _frames[_frontFrame ^ 1]; }
+	void	commitFrame();
+#if RGBWW_DITHER_BITS > 0
+	RGBWWDither _dither;
+	unsigned long _last_dither;
+
+	void ditherOutput();
+#endif
 
 	void (*_animationcallback)(RGBWWLed* led) = NULL;
 
 	//helpers
-	void cleanupCurrentAnimation();
-	void cleanupAnimationQ();
+	void cleanupOutput();
+
+};
+
+
+/**
+ * Controller with color mode and HSV model fixed at compile time.
+ *
+ * The HSV output pipeline is resolved by the compiler, so no runtime
+ * switch on the color mode or the HSV model is executed per frame.
+ * Changing the color mode or HSV model via colorutils has no effect
+ * on the output of this controller.
+ *
+ * Use RGBWWLed if the modes need to be changed at runtime.
+ *
+ * @tparam MODE		RGBWW_COLORMODE
+ * @tparam MODEL	RGBWW_HSVMODEL
+ */
+template<RGBWW_COLORMODE MODE, RGBWW_HSVMODEL MODEL>
+class RGBWWLedStatic : public RGBWWLed
+{
+public:
 
+	RGBWWLedStatic() {
+		colorutils.setColorMode(MODE);
+		colorutils.setHSVmodel(MODEL);
+	}
+
+	using RGBWWLed::setOutput;
+
+	void setOutput(HSVCT& outputcolor) {
+		RGBWCT rgbwk;
+		ChannelOutput output;
+		_current_color = outputcolor;
+		RGBWW_PROFILE_BEGIN(PROFILE_HSVTORGB);
+		colorutils.HSVtoRGB<MODEL>(outputcolor, rgbwk);
+		RGBWW_PROFILE_END(PROFILE_HSVTORGB);
+		RGBWW_PROFILE_BEGIN(PROFILE_WHITEBALANCE);
+		colorutils.whiteBalance<MODE>(rgbwk, output);
+		RGBWW_PROFILE_END(PROFILE_WHITEBALANCE);
+		RGBWWLed::setOutput(output);
+	}
+
+	void setOutput(RGBWCT& outputcolor) {
+		ChannelOutput output;
+		RGBWW_PROFILE_BEGIN(PROFILE_WHITEBALANCE);
+		colorutils.whiteBalance<MODE>(outputcolor, output);
+		RGBWW_PROFILE_END(PROFILE_WHITEBALANCE);
+		RGBWWLed::setOutput(output);
+	}
 };
 
 #endif //RGBWWLed_h
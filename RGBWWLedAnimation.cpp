@@ -6,8 +6,8 @@
  * All files of this project are provided under the LGPL v3 license.
  */
 
-#include "RGBWWLedAnimation.h"
 #include "RGBWWLed.h"
+#include "RGBWWLedAnimation.h"
 #include "RGBWWLedColor.h"
 
 /**************************************************************
@@ -91,37 +91,27 @@ bool HSVTransition::init() {
 	_steps = (_steps > 0) ? _steps : int(1); //avoid 0 division
 
 
-	//HUE
-	hue.delta = (d == -1) ? l : r;
-	hue.step = 1;
-	hue.step = (hue.delta < _steps) ? (hue.step <<8) : (hue.delta << 8)/_steps;
-	hue.step *= d;
-	hue.error = -1 * _steps;
-	hue.count = 0;
+	//HUE - distance in the direction of the turn
+	hue.init(0, (d == -1) ? -l : r, _steps);
 
 	//SATURATION
-	sat.delta = abs(_basecolor.s - _finalcolor.s);
-	sat.step = 1;
-	sat.step = (sat.delta < _steps) ? (sat.step << 8) : (sat.delta << 8)/_steps;
-	sat.step = (_basecolor.s > _finalcolor.s) ? sat.step*=-1 : sat.step;
-	sat.error = -1* _steps;
-	sat.count = 0;
+	sat.init(_basecolor.s, _finalcolor.s, _steps);
 
 	//VALUE
-	val.delta = abs(_basecolor.v - _finalcolor.v);
-	val.step = 1;
-	val.step = (val.delta < _steps) ? (val.step << 8) : (val.delta << 8)/_steps;
-	val.step = (_basecolor.v > _finalcolor.v) ? val.step*=-1 : val.step;
-	val.error = -1*_steps;
-	val.count = 0;
+	val.init(_basecolor.v, _finalcolor.v, _steps);
 
 	//KELVIN
-	ct.delta = abs(_basecolor.ct - _finalcolor.ct);
-	ct.step = 1;
-	ct.step = (ct.delta < _steps) ? (ct.step << 8 ): (ct.delta << 8)/_steps;
-	ct.step = (_basecolor.ct > _finalcolor.ct) ? ct.step*=-1 : ct.step;
-	ct.error = -1 * _steps;
-	ct.count = 0;
+	// interpolated in mired if both colors have a valid color temperature
+	int ctfinal = _finalcolor.ct;
+	_basect = _basecolor.ct;
+	_ctmired = _basecolor.ct >= RGBWW_KELVIN_MIN && _basecolor.ct <= RGBWW_KELVIN_MAX &&
+			_finalcolor.ct >= RGBWW_KELVIN_MIN && _finalcolor.ct <= RGBWW_KELVIN_MAX;
+	if (_ctmired) {
+		_basect = RGBWWColorUtils::kelvinToMired(_basecolor.ct);
+		ctfinal = RGBWWColorUtils::kelvinToMired(_finalcolor.ct);
+	}
+	_currentct = _basect;
+	ct.init(_basect, ctfinal, _steps);
 	return true;
 }
 
@@ -135,8 +125,8 @@ bool HSVTransition::run () {
 		}
 		_currentstep = 0;
 	}
-	debugRGBW("HSVTransition::run CURRENT  H %i | S %i | V %i | K %i", _currentcolor.h, _currentcolor.s, _currentcolor.v, _currentcolor.ct);
-	debugRGBW("HSVTransition::run FINAL    H %i | S %i | V %i | K %i", _finalcolor.h, _finalcolor.s, _finalcolor.v, _finalcolor.ct);
+	traceRGBW(TRACE_HSV_CURRENT, _currentcolor.h, _currentcolor.s, _currentcolor.v, _currentcolor.ct);
+	traceRGBW(TRACE_HSV_FINAL, _finalcolor.h, _finalcolor.s, _finalcolor.v, _finalcolor.ct);
 	_currentstep++;
 	if (_currentstep >= _steps) {
 		// ensure that the with the last step
@@ -147,13 +137,16 @@ bool HSVTransition::run () {
 	rgbwwctrl->setOutput(_currentcolor);
 
 	//calculate new colors with bresenham
-	_currentcolor.h = bresenham(hue, _steps, _basecolor.h, _currentcolor.h);
-	_currentcolor.s = bresenham(sat, _steps, _basecolor.s, _currentcolor.s);
-	_currentcolor.v = bresenham(val, _steps,_basecolor.v, _currentcolor.v);
-	_currentcolor.ct = bresenham(ct, _steps, _basecolor.ct, _currentcolor.ct);
+	RGBWW_PROFILE_BEGIN(PROFILE_ANIMATION);
+	_currentcolor.h = hue.next(_steps, _basecolor.h, _currentcolor.h);
+	_currentcolor.s = sat.next(_steps, _basecolor.s, _currentcolor.s);
+	_currentcolor.v = val.next(_steps, _basecolor.v, _currentcolor.v);
+	_currentct = ct.next(_steps, _basect, _currentct);
+	_currentcolor.ct = (_ctmired) ? RGBWWColorUtils::miredToKelvin(_currentct) : _currentct;
 
 	//fix hue
 	RGBWWColorUtils::circleHue(_currentcolor.h);
+	RGBWW_PROFILE_END(PROFILE_ANIMATION);
 
 
 	return false;
@@ -164,18 +157,6 @@ void HSVTransition::reset() {
 }
 
 
-int HSVTransition::bresenham(BresenhamValues& values, int& dx, int& base, int& current) {
-	//more information on bresenham:
-	//https://www.cs.helsinki.fi/group/goa/mallinnus/lines/bresenh.html
-	values.error = values.error + 2 * values.delta;
-	if (values.error > 0) {
-		values.count += 1;
-		values.error = values.error - 2*dx;
-		return base + ((values.count * values.step) >> 8);
-	}
-	return current;
-}
-
 /**************************************************************
  *               RAWSetOutput
  **************************************************************/
@@ -210,7 +191,8 @@ bool RAWSetOutput::run() {
  **************************************************************/
 
 
-RAWTransition::RAWTransition(const ChannelOutput& output, const int& time, RGBWWLed* ctrl ) {
+RAWTransition::RAWTransition(const ChannelOutput& output, const int& time, RGBWWLed* ctrl, bool mired /* = false */) {
+	_miredmode = mired;
 	rgbwwctrl = ctrl;
 	_finalcolor = output;
 	_hasbasecolor = false;
@@ -219,7 +201,8 @@ RAWTransition::RAWTransition(const ChannelOutput& output, const int& time, RGBWW
 }
 
 
-RAWTransition::RAWTransition(const ChannelOutput& output_from, const ChannelOutput& output, const int& time, RGBWWLed* ctrl ) {
+RAWTransition::RAWTransition(const ChannelOutput& output_from, const ChannelOutput& output, const int& time, RGBWWLed* ctrl, bool mired /* = false */) {
+	_miredmode = mired;
 	rgbwwctrl = ctrl;
 	_finalcolor = output;
 	_basecolor = output_from;
@@ -245,49 +228,38 @@ bool RAWTransition::init() {
 	_steps = (_steps > 0) ? _steps : int(1); //avoid 0 division
 
 
-	// RED
-	red.delta = abs(_basecolor.r - _finalcolor.r);
-	red.step = 1;
-	red.step = (red.delta < _steps) ? (red.step << 8) : (red.delta << 8)/_steps;
-	red.step = (_basecolor.r > _finalcolor.r) ? red.step*=-1 : red.step;
-	red.error = -1* _steps;
-	red.count = 0;
-
-	// GREEN
-	green.delta = abs(_basecolor.g - _finalcolor.g);
-	green.step = 1;
-	green.step = (green.delta < _steps) ? (green.step << 8) : (green.delta << 8)/_steps;
-	green.step = (_basecolor.g > _finalcolor.g) ? green.step*=-1 : green.step;
-	green.error = -1* _steps;
-	green.count = 0;
-
-	// BLUE
-	blue.delta = abs(_basecolor.b - _finalcolor.b);
-	blue.step = 1;
-	blue.step = (blue.delta < _steps) ? (blue.step << 8) : (blue.delta << 8)/_steps;
-	blue.step = (_basecolor.b > _finalcolor.b) ? blue.step*=-1 : blue.step;
-	blue.error = -1* _steps;
-	blue.count = 0;
-
-	// WW
-	warmwhite.delta = abs(_basecolor.ww - _finalcolor.ww);
-	warmwhite.step = 1;
-	warmwhite.step = (warmwhite.delta < _steps) ? (warmwhite.step << 8) : (warmwhite.delta << 8)/_steps;
-	warmwhite.step = (_basecolor.ww > _finalcolor.ww) ? warmwhite.step*=-1 : warmwhite.step;
-	warmwhite.error = -1* _steps;
-	warmwhite.count = 0;
-
-	// CW
-	coldwhite.delta = abs(_basecolor.cw - _finalcolor.cw);
-	coldwhite.step = 1;
-	coldwhite.step = (coldwhite.delta < _steps) ? (coldwhite.step << 8) : (coldwhite.delta << 8)/_steps;
-	coldwhite.step = (_basecolor.cw > _finalcolor.cw) ? coldwhite.step*=-1 : coldwhite.step;
-	coldwhite.error = -1* _steps;
-	coldwhite.count = 0;
+	red.init(_basecolor.r, _finalcolor.r, _steps);
+	green.init(_basecolor.g, _finalcolor.g, _steps);
+	blue.init(_basecolor.b, _finalcolor.b, _steps);
+	warmwhite.init(_basecolor.ww, _finalcolor.ww, _steps);
+	coldwhite.init(_basecolor.cw, _finalcolor.cw, _steps);
+
+	// only white changes - fade brightness and color temperature
+	// (share of warm white, linear in mired) independently
+	_mired = _miredmode && (_basecolor.r == _finalcolor.r && _basecolor.g == _finalcolor.g && _basecolor.b == _finalcolor.b);
+	if (_mired) {
+		initMired();
+	}
 	return true;
 }
 
 
+void RAWTransition::initMired() {
+	int totalfinal = _finalcolor.ww + _finalcolor.cw;
+	_basetotal = _basecolor.ww + _basecolor.cw;
+	_basewarm = (_basetotal > 0) ? (RGBWW_CALC_WIDE(_basecolor.ww) * RGBWW_CALC_MAXVAL) / _basetotal : 0;
+	int warmfinal = (totalfinal > 0) ? (RGBWW_CALC_WIDE(_finalcolor.ww) * RGBWW_CALC_MAXVAL) / totalfinal : 0;
+	// fading from/to off keeps the color temperature
+	if (_basetotal == 0) _basewarm = warmfinal;
+	if (totalfinal == 0) warmfinal = _basewarm;
+	_currenttotal = _basetotal;
+	_currentwarm = _basewarm;
+
+	total.init(_basetotal, totalfinal, _steps);
+	warm.init(_basewarm, warmfinal, _steps);
+}
+
+
 
 bool RAWTransition::run () {
 
@@ -297,8 +269,8 @@ bool RAWTransition::run () {
 		}
 		_currentstep = 1;
 	}
-	debugRGBW("RAWTransition::run CURRENT  R %i | G %i | B %i | WW %i | CW %i  ", _currentcolor.r, _currentcolor.g, _currentcolor.b, _currentcolor.ww, _currentcolor.cw);
-	debugRGBW("RAWTransition::run FINAL    R %i | G %i | B %i | WW %i | CW %i ", _finalcolor.r, _finalcolor.g, _finalcolor.b, _finalcolor.ww, _finalcolor.cw);
+	traceRGBW(TRACE_RAW_CURRENT, _currentcolor.r, _currentcolor.g, _currentcolor.b, _currentcolor.ww, _currentcolor.cw);
+	traceRGBW(TRACE_RAW_FINAL, _finalcolor.r, _finalcolor.g, _finalcolor.b, _finalcolor.ww, _finalcolor.cw);
 
 
 	if (_currentstep >= _steps) {
@@ -310,11 +282,20 @@ bool RAWTransition::run () {
 	rgbwwctrl->setOutput(_currentcolor);
 	_currentstep++;
 	//calculate new colors with bresenham
-	_currentcolor.r = bresenham(red, _steps, _basecolor.r, _currentcolor.r);
-	_currentcolor.g = bresenham(green, _steps, _basecolor.g, _currentcolor.g);
-	_currentcolor.b = bresenham(blue, _steps,_basecolor.b, _currentcolor.b);
-	_currentcolor.ww = bresenham(warmwhite, _steps, _basecolor.ww, _currentcolor.ww);
-	_currentcolor.cw = bresenham(coldwhite, _steps, _basecolor.cw, _currentcolor.cw);
+	RGBWW_PROFILE_BEGIN(PROFILE_ANIMATION);
+	_currentcolor.r = red.next(_steps, _basecolor.r, _currentcolor.r);
+	_currentcolor.g = green.next(_steps, _basecolor.g, _currentcolor.g);
+	_currentcolor.b = blue.next(_steps, _basecolor.b, _currentcolor.b);
+	if (_mired) {
+		_currenttotal = total.next(_steps, _basetotal, _currenttotal);
+		_currentwarm = warm.next(_steps, _basewarm, _currentwarm);
+		_currentcolor.ww = (RGBWW_CALC_WIDE(_currenttotal) * _currentwarm) / RGBWW_CALC_MAXVAL;
+		_currentcolor.cw = _currenttotal - _currentcolor.ww;
+	} else {
+		_currentcolor.ww = warmwhite.next(_steps, _basecolor.ww, _currentcolor.ww);
+		_currentcolor.cw = coldwhite.next(_steps, _basecolor.cw, _currentcolor.cw);
+	}
+	RGBWW_PROFILE_END(PROFILE_ANIMATION);
 
 
 
@@ -326,18 +307,116 @@ void RAWTransition::reset() {
 }
 
 
-int RAWTransition::bresenham(BresenhamValues& values, int& dx, int& base, int& current) {
-	//more information on bresenham:
-	//https://www.cs.helsinki.fi/group/goa/mallinnus/lines/bresenh.html
-	values.error = values.error + 2 * values.delta;
-	if (values.error > 0) {
-		values.count += 1;
-		values.error = values.error - 2*dx;
-		return base + ((values.count * values.step) >> 8);
+/**************************************************************
+                Frame Stream
+ **************************************************************/
+
+RGBWWCallbackSource::RGBWWCallbackSource(RGBWW_STREAM_STATE (*func)(ChannelOutput& frame, uint32_t index, void* arg), void* arg /* = NULL */) {
+	_func = func;
+	_arg = arg;
+	_index = 0;
+}
+
+RGBWW_STREAM_STATE RGBWWCallbackSource::nextFrame(ChannelOutput& frame) {
+	RGBWW_STREAM_STATE state = _func(frame, _index, _arg);
+	if (state == RGBWW_STREAM_STATE::STREAM_FRAME) {
+		_index++;
+	}
+	return state;
+}
+
+
+RGBWWFrameStream::RGBWWFrameStream(RGBWWFrameSource* source, int readahead /* = RGBWW_STREAM_READAHEAD */) {
+	_source = source;
+	_size = (readahead > 0) ? readahead : 1;
+	_frames = new ChannelOutput[_size];
+	clear();
+	resetStats();
+}
+
+RGBWWFrameStream::~RGBWWFrameStream() {
+	delete[] _frames;
+}
+
+int RGBWWFrameStream::fill() {
+	while (_count < _size && !_ended) {
+		int back = _front + _count;
+		if (back >= _size) back -= _size;
+		RGBWW_STREAM_STATE state = _source->nextFrame(_frames[back]);
+		if (state == RGBWW_STREAM_STATE::STREAM_END) {
+			_ended = true;
+		} else if (state == RGBWW_STREAM_STATE::STREAM_WAIT) {
+			break;
+		} else {
+			_count++;
+		}
+	}
+	if (!_playing && (_count == _size || _ended)) {
+		_playing = true;
+	}
+	return _count;
+}
+
+RGBWW_STREAM_STATE RGBWWFrameStream::pop(ChannelOutput& frame) {
+	fill();
+	if (!_playing) {
+		return RGBWW_STREAM_STATE::STREAM_WAIT;
+	}
+	if (_count == 0) {
+		if (_ended) {
+			return RGBWW_STREAM_STATE::STREAM_END;
+		}
+		_stats.underruns++;
+		_stats.minfill = 0;
+		return RGBWW_STREAM_STATE::STREAM_WAIT;
+	}
+	if (_count < _stats.minfill) {
+		_stats.minfill = _count;
+	}
+	if (_count > _stats.maxfill) {
+		_stats.maxfill = _count;
+	}
+	frame = _frames[_front];
+	_front = (_front + 1 < _size) ? _front + 1 : 0;
+	_count--;
+	_stats.frames++;
+	return RGBWW_STREAM_STATE::STREAM_FRAME;
+}
+
+void RGBWWFrameStream::clear() {
+	_count = 0;
+	_front = 0;
+	_ended = false;
+	_playing = false;
+}
+
+RGBWWStreamStats RGBWWFrameStream::getStats() {
+	return _stats;
+}
+
+void RGBWWFrameStream::resetStats() {
+	_stats.frames = 0;
+	_stats.underruns = 0;
+	_stats.minfill = _size;
+	_stats.maxfill = 0;
+}
+
+
+RGBWWStreamAnimation::RGBWWStreamAnimation(RGBWWFrameStream* stream, RGBWWLed* ctrl) {
+	_stream = stream;
+	rgbwwctrl = ctrl;
+}
+
+bool RGBWWStreamAnimation::run() {
+	ChannelOutput frame;
+	RGBWW_STREAM_STATE state = _stream->pop(frame);
+	if (state == RGBWW_STREAM_STATE::STREAM_FRAME) {
+		rgbwwctrl->setOutput(frame);
 	}
-	return current;
+	return state == RGBWW_STREAM_STATE::STREAM_END;
 }
 
+
 /**************************************************************
                 Animation Set
  **************************************************************/
@@ -458,3 +537,144 @@ RGBWWLedAnimation* RGBWWLedAnimationQ::pop() {
 	}
 	return NULL;
 }
+
+
+/**************************************************************
+ *               Animation Player
+ **************************************************************/
+
+RGBWWAnimationPlayer::RGBWWAnimationPlayer(int qsize /* = RGBWW_ANIMATIONQSIZE */) : _queue(qsize) {
+	_current = NULL;
+	_cancel = false;
+	_clear = false;
+	_lastActive = 0;
+	_lastFrame = 0;
+	_frameTimed = false;
+	resetFrameStats();
+}
+
+
+RGBWWAnimationPlayer::~RGBWWAnimationPlayer() {
+	stop();
+}
+
+
+bool RGBWWAnimationPlayer::push(RGBWWLedAnimation* animation) {
+	return _queue.push(animation);
+}
+
+
+void RGBWWAnimationPlayer::stop() {
+	_queue.clear();
+	_clear = false;
+	finish();
+}
+
+
+void RGBWWAnimationPlayer::skip() {
+	if (_current != NULL) {
+		_cancel = true;
+	}
+}
+
+
+void RGBWWAnimationPlayer::clear() {
+	_clear = true;
+}
+
+
+bool RGBWWAnimationPlayer::isActive() {
+	return _current != NULL;
+}
+
+
+bool RGBWWAnimationPlayer::isFull() {
+	return _queue.isFull();
+}
+
+
+RGBWWLedAnimation* RGBWWAnimationPlayer::getCurrent() {
+	return _current;
+}
+
+
+RGBWWLedAnimation* RGBWWAnimationPlayer::nextFrame() {
+	// check if we need to cancel effect
+	if (_cancel) {
+		finish();
+		_cancel = false;
+	}
+	// cleanup Q if we cancel all effects
+	if (_clear) {
+		_queue.clear();
+		_clear = false;
+	}
+
+	#ifdef RGBWW_FRAME_GATE
+		//only need this part when using arduino
+		unsigned long now = millis();
+		if (now - _lastActive < RGBWW_MINTIMEDIFF) {
+			// Interval hasn't passed yet - only early if there is something to show
+			if (_current != NULL || !_queue.isEmpty()) {
+				_frameStats.early++;
+			}
+			return NULL;
+		}
+		_lastActive = now;
+	#endif // RGBWW_FRAME_GATE
+
+	// check if we need to animate or there is any new animation
+	if (_current == NULL) {
+		if (_queue.isEmpty()) {
+			_frameTimed = false;
+			return NULL;
+		}
+		_current = _queue.pop();
+	}
+	trackFrame();
+	return _current;
+}
+
+
+void RGBWWAnimationPlayer::finish() {
+	if (_current != NULL) {
+		delete _current;
+		_current = NULL;
+	}
+}
+
+
+void RGBWWAnimationPlayer::trackFrame() {
+	unsigned long now = micros();
+	if (_frameTimed) {
+		const unsigned long target = RGBWW_MINTIMEDIFF * 1000UL;
+		unsigned long interval = now - _lastFrame;
+		_frameStats.frames++;
+		unsigned long bucket = interval / (target / 4);
+		if (bucket >= RGBWW_FRAMESTATS_BUCKETS) {
+			bucket = RGBWW_FRAMESTATS_BUCKETS - 1;
+		}
+		if (_frameStats.histogram[bucket] < 0xFFFF) {
+			_frameStats.histogram[bucket]++;
+		}
+		if (interval > target + RGBWW_FRAMESTATS_TOLERANCE) {
+			_frameStats.late++;
+			_frameStats.missed += interval / target - 1;
+			if (interval - target > _frameStats.maxlateness) {
+				_frameStats.maxlateness = interval - target;
+			}
+		}
+	}
+	_lastFrame = now;
+	_frameTimed = true;
+}
+
+
+RGBWWFrameStats RGBWWAnimationPlayer::getFrameStats() {
+	return _frameStats;
+}
+
+
+void RGBWWAnimationPlayer::resetFrameStats() {
+	memset(&_frameStats, 0, sizeof(_frameStats));
+}
@@ -14,6 +14,7 @@
 
 class RGBWWLed;
 class RGBWWLedAnimation;
+template<int CHANNELS> class RGBWWMultiLed;
 
 /**
  * A simple queue implementation
@@ -122,6 +123,135 @@ public:
 	virtual void reset() {};
 };
 
+/**
+ * Timing of the animation frames
+ *
+ * Intervals are measured between frames of running animations,
+ * idle periods without animation are not counted
+ *
+ * Only arduino gates show() by RGBWW_MINTIMEDIFF (RGBWW_FRAME_GATE) and
+ * counts early calls while an animation is running or queued. Other
+ * platforms (i.e. Sming) call show() from a timer at RGBWW_UPDATEFREQUENCY,
+ * every call is a frame and early stays 0 - calling show() too often
+ * shows up as short intervals instead.
+ */
+struct RGBWWFrameStats {
+	uint32_t	frames;		// measured frame intervals
+	uint32_t	late;		// intervals longer than RGBWW_MINTIMEDIFF + RGBWW_FRAMESTATS_TOLERANCE
+	uint32_t	missed;		// frames dropped because of long intervals
+	uint32_t	early;		// show() calls before the interval passed (arduino only - see above)
+	uint32_t	maxlateness;	// us
+	uint16_t	histogram[RGBWW_FRAMESTATS_BUCKETS];	// saturates at 0xFFFF
+};
+
+
+
+/**
+ * Plays the animations of a controller
+ *
+ * Holds the animation queue and the running animation, limits the
+ * frame rate (arduino) and tracks the frame timing. Shared by
+ * RGBWWLed and RGBWWMultiLed
+ *
+ */
+class RGBWWAnimationPlayer
+{
+public:
+	RGBWWAnimationPlayer(int qsize = RGBWW_ANIMATIONQSIZE);
+	~RGBWWAnimationPlayer();
+
+	/**
+	 * Add an animation to the queue. The player deletes
+	 * the animation when it is finished or removed
+	 *
+	 * @param 	animation
+	 * @retval 	true 	animation was added
+	 * @retval	false	queue is full
+	 */
+	bool push(RGBWWLedAnimation* animation);
+
+	/**
+	 * Remove the running animation and all queued animations
+	 *
+	 */
+	void stop();
+
+	/**
+	 * Skip the running animation with the next frame
+	 *
+	 */
+	void skip();
+
+	/**
+	 * Remove all queued animations with the next frame
+	 *
+	 */
+	void clear();
+
+	/**
+	 * Check if an animation is running
+	 *
+	 * @retval true		an animation is running
+	 * @retval false	no animation is running
+	 */
+	bool isActive();
+
+	/**
+	 * Check if the queue is full
+	 *
+	 * @retval true		queue is full
+	 * @retval false	queue is not full
+	 */
+	bool isFull();
+
+	/**
+	 * Returns the running animation
+	 *
+	 * @return RGBWWLedAnimation* (NULL if no animation is running)
+	 */
+	RGBWWLedAnimation* getCurrent();
+
+	/**
+	 * Start the next frame - applies skip() and clear(), takes the
+	 * next animation from the queue and tracks the frame timing
+	 *
+	 * @return animation to run for this frame (NULL if no frame is due)
+	 */
+	RGBWWLedAnimation* nextFrame();
+
+	/**
+	 * Delete the running animation after it finished
+	 *
+	 */
+	void finish();
+
+	/**
+	 * Returns the frame timing statistics
+	 *
+	 * @return RGBWWFrameStats
+	 */
+	RGBWWFrameStats getFrameStats();
+
+	/**
+	 * Reset the frame timing statistics
+	 *
+	 */
+	void resetFrameStats();
+
+private:
+	RGBWWLedAnimationQ	_queue;
+	RGBWWLedAnimation*	_current;
+	bool	_cancel;
+	bool	_clear;
+	unsigned long _lastActive;
+	unsigned long _lastFrame;
+	bool	_frameTimed;
+	RGBWWFrameStats _frameStats;
+
+	void trackFrame();
+};
+
+
 /**
  * Set output to color without effect/transition
  *
@@ -150,8 +280,50 @@ private:
 };
 
 
+/**
+ * Stepping of a value over the frames of a transition
+ * (bresenham line with 8 fractional bits per step)
+ *
+ * more information on bresenham:
+ * https://www.cs.helsinki.fi/group/goa/mallinnus/lines/bresenh.html
+ */
 struct BresenhamValues {
 	int delta, error, count, step;
+
+	/**
+	 * Prepare the stepping from base to target
+	 *
+	 * @param base		value at the beginning
+	 * @param target	value at the end
+	 * @param steps		number of steps (> 0)
+	 */
+	void init(int base, int target, int steps) {
+		delta = abs(base - target);
+		step = (delta < steps) ? (1 << 8) : (delta << 8) / steps;
+		if (base > target) {
+			step = -step;
+		}
+		error = -1 * steps;
+		count = 0;
+	}
+
+	/**
+	 * Calculate the value of the next step
+	 *
+	 * @param steps		number of steps
+	 * @param base		value at the beginning
+	 * @param current	value of the current step
+	 * @return value of the next step
+	 */
+	int next(int steps, int base, int current) {
+		error = error + 2 * delta;
+		if (error > 0) {
+			count += 1;
+			error = error - 2 * steps;
+			return base + ((count * step) >> 8);
+		}
+		return current;
+	}
 };
 
 /**
@@ -201,10 +373,13 @@ private:
 	BresenhamValues sat;
 	BresenhamValues val;
 	BresenhamValues ct;
+	// color temperature is interpolated in mired
+	bool	_ctmired;
+	int		_basect;
+	int		_currentct;
 
 
 	RGBWWLed*    rgbwwctrl;
-	static	int bresenham(BresenhamValues& values, int& dx, int& base, int& current);
 };
 
 
@@ -252,8 +427,10 @@ public:
 	 * @param output		output at the end of the transition
 	 * @param time			the amount of time the transition takes in ms
 	 * @param ctrl			main RGBWWLed object for calling setOutput
+	 * @param mired			fade brightness and color temperature (in mired) of
+	 * 						ww/cw independently if only ww/cw change
 	 */
-	RAWTransition(const ChannelOutput& output, const int& time, RGBWWLed* ctrl);
+	RAWTransition(const ChannelOutput& output, const int& time, RGBWWLed* ctrl, bool mired = false);
 
 	/**
 	 * Fade from one output state (output_from) to another(output)
@@ -262,14 +439,17 @@ public:
 	 * @param output		output at the end of the transition
 	 * @param time			the amount of time the transition takes in ms
 	 * @param ctrl			main RGBWWLed object for calling setOutput
+	 * @param mired			fade brightness and color temperature (in mired) of
+	 * 						ww/cw independently if only ww/cw change
 	 */
-	RAWTransition(const ChannelOutput& output_from, const ChannelOutput& output, const int& time, RGBWWLed* ctrl);
+	RAWTransition(const ChannelOutput& output_from, const ChannelOutput& output, const int& time, RGBWWLed* ctrl, bool mired = false);
 
 	void reset();
 	bool run();
 
 private:
 	bool init();
+	void initMired();
 
 	ChannelOutput	_basecolor;
 	ChannelOutput	_currentcolor;
@@ -282,10 +462,271 @@ private:
 	BresenhamValues blue;
 	BresenhamValues warmwhite;
 	BresenhamValues coldwhite;
+	// mired mode - total white and share of warm white
+	bool	_miredmode;
+	bool	_mired;
+	int		_basetotal;
+	int		_currenttotal;
+	int		_basewarm;
+	int		_currentwarm;
+	BresenhamValues total;
+	BresenhamValues warm;
 
 
 	RGBWWLed*    rgbwwctrl;
-	static	int bresenham(BresenhamValues& values, int& dx, int& base, int& current);
+};
+
+
+/**
+ * Fade of a controller with CHANNELS channels from one output state to another
+ *
+ * @tparam CHANNELS	number of channels
+ */
+template<int CHANNELS>
+class RGBWWMultiTransition: public RGBWWLedAnimation
+{
+public:
+
+	/**
+	 * Fade from the current output to a new one (output)
+	 *
+	 * @param output		output at the end of the transition
+	 * @param time			the amount of time the transition takes in ms
+	 * @param ctrl			controller object for calling setOutput
+	 */
+	RGBWWMultiTransition(const RGBWWChannelValues<CHANNELS>& output, int time, RGBWWMultiLed<CHANNELS>* ctrl) {
+		rgbwwctrl = ctrl;
+		_finalcolor = output;
+		_hasbasecolor = false;
+		_steps = time / RGBWW_MINTIMEDIFF;
+		_currentstep = 0;
+	}
+
+	/**
+	 * Fade from one output state (output_from) to another(output)
+	 *
+	 * @param output_from	output at the beginning
+	 * @param output		output at the end of the transition
+	 * @param time			the amount of time the transition takes in ms
+	 * @param ctrl			controller object for calling setOutput
+	 */
+	RGBWWMultiTransition(const RGBWWChannelValues<CHANNELS>& output_from, const RGBWWChannelValues<CHANNELS>& output, int time, RGBWWMultiLed<CHANNELS>* ctrl) {
+		rgbwwctrl = ctrl;
+		_finalcolor = output;
+		_basecolor = output_from;
+		_hasbasecolor = true;
+		_steps = time / RGBWW_MINTIMEDIFF;
+		_currentstep = 0;
+	}
+
+	void reset() {
+		_currentstep = 0;
+	}
+
+	bool run() {
+		if (_currentstep == 0) {
+			if (!init()) {
+				return true;
+			}
+			_currentstep = 1;
+		}
+		if (_currentstep >= _steps) {
+			// ensure that the with the last step
+			// we arrive at the destination color
+			rgbwwctrl->setOutput(_finalcolor);
+			return true;
+		}
+		rgbwwctrl->setOutput(_currentcolor);
+		_currentstep++;
+		//calculate new colors with bresenham
+		for (int i = 0; i < CHANNELS; i++) {
+			_currentcolor[i] = _values[i].next(_steps, _basecolor[i], _currentcolor[i]);
+		}
+		return false;
+	}
+
+private:
+	bool init() {
+		if (!_hasbasecolor) {
+			_basecolor = rgbwwctrl->getCurrentOutput();
+		}
+
+		// don`t animate if the color is already the same
+		if (_basecolor == _finalcolor) {
+			return false;
+		}
+		_currentcolor = _basecolor;
+
+		// calculate steps per time
+		_steps = (_steps > 0) ? _steps : int(1); //avoid 0 division
+
+		for (int i = 0; i < CHANNELS; i++) {
+			_values[i].init(_basecolor[i], _finalcolor[i], _steps);
+		}
+		return true;
+	}
+
+	RGBWWChannelValues<CHANNELS>	_basecolor;
+	RGBWWChannelValues<CHANNELS>	_currentcolor;
+	RGBWWChannelValues<CHANNELS>	_finalcolor;
+	bool	_hasbasecolor;
+	int	_currentstep;
+	int _steps;
+	BresenhamValues _values[CHANNELS];
+
+	RGBWWMultiLed<CHANNELS>*    rgbwwctrl;
+};
+
+
+/*
+ * frames buffered ahead by RGBWWFrameStream - bridges delays
+ * of the source (i.e. network or file i/o) of up to
+ * RGBWW_STREAM_READAHEAD * RGBWW_MINTIMEDIFF ms
+ */
+#ifndef RGBWW_STREAM_READAHEAD
+	#define RGBWW_STREAM_READAHEAD 8
+#endif
+
+enum RGBWW_STREAM_STATE {
+	STREAM_FRAME = 0,	// frame produced
+	STREAM_WAIT = 1,	// no frame available yet
+	STREAM_END = 2		// end of the stream
+};
+
+/**
+ * Source of the frames of a RGBWWFrameStream (i.e. file, socket or
+ * procedural generator)
+ *
+ */
+class RGBWWFrameSource
+{
+public:
+	virtual ~RGBWWFrameSource() {};
+
+	/**
+	 * Produce the next frame. Must not block - return
+	 * RGBWW_STREAM_STATE::STREAM_WAIT if the frame is not available yet
+	 *
+	 * @param ChannelOutput&	frame	holds the produced frame
+	 * @return RGBWW_STREAM_STATE
+	 */
+	virtual RGBWW_STREAM_STATE nextFrame(ChannelOutput& frame) = 0;
+};
+
+/**
+ * Frame source calling a function for each frame
+ *
+ */
+class RGBWWCallbackSource: public RGBWWFrameSource
+{
+public:
+	/**
+	 * @param func	called with the frame to fill, the index of the frame
+	 * 				and arg
+	 * @param arg	passed to func
+	 */
+	RGBWWCallbackSource(RGBWW_STREAM_STATE (*func)(ChannelOutput& frame, uint32_t index, void* arg), void* arg = NULL);
+
+	RGBWW_STREAM_STATE nextFrame(ChannelOutput& frame);
+
+private:
+	RGBWW_STREAM_STATE (*_func)(ChannelOutput& frame, uint32_t index, void* arg);
+	void*		_arg;
+	uint32_t	_index;
+};
+
+/**
+ * Statistics of a RGBWWFrameStream
+ *
+ */
+struct RGBWWStreamStats {
+	uint32_t	frames;		// frames played
+	uint32_t	underruns;	// frames repeated because the buffer was empty
+	uint16_t	minfill;	// lowest number of buffered frames while playing
+	uint16_t	maxfill;
+};
+
+/**
+ * Frames pulled from a source into a bounded read ahead buffer
+ *
+ * The buffer is filled before each frame is played. Additionally fill()
+ * can be called from the main loop to use idle time for reading ahead.
+ * Playback starts once the buffer is full (or the source ended).
+ *
+ */
+class RGBWWFrameStream
+{
+public:
+	/**
+	 * @param RGBWWFrameSource*	source	not deleted by the stream
+	 * @param int	readahead	number of frames buffered
+	 */
+	RGBWWFrameStream(RGBWWFrameSource* source, int readahead = RGBWW_STREAM_READAHEAD);
+	~RGBWWFrameStream();
+
+	/**
+	 * Pull frames from the source until the buffer is full
+	 * or the source has no frame available
+	 *
+	 * @return int	number of buffered frames
+	 */
+	int		fill();
+
+	/**
+	 * Take the next frame from the buffer
+	 *
+	 * @param ChannelOutput&	frame
+	 * @return RGBWW_STREAM_STATE	STREAM_WAIT on buffer underrun or while prebuffering
+	 */
+	RGBWW_STREAM_STATE pop(ChannelOutput& frame);
+
+	/**
+	 * Discard the buffered frames and prebuffer again
+	 *
+	 */
+	void	clear();
+
+	/**
+	 * Returns the statistics of the stream
+	 *
+	 * @return RGBWWStreamStats
+	 */
+	RGBWWStreamStats getStats();
+
+	void	resetStats();
+
+private:
+	RGBWWFrameSource*	_source;
+	ChannelOutput*	_frames;
+	int		_size;
+	int		_count;
+	int		_front;
+	bool	_ended;
+	bool	_playing;
+	RGBWWStreamStats _stats;
+};
+
+/**
+ * Plays the frames of a RGBWWFrameStream
+ *
+ * On a buffer underrun the current output is held. The animation
+ * finishes when the source ended and all frames are played.
+ *
+ */
+class RGBWWStreamAnimation: public RGBWWLedAnimation
+{
+public:
+	/**
+	 * @param RGBWWFrameStream*	stream	not deleted by the animation
+	 * @param RGBWWLed*	ctrl
+	 */
+	RGBWWStreamAnimation(RGBWWFrameStream* stream, RGBWWLed* ctrl);
+
+	bool run();
+
+private:
+	RGBWWFrameStream*	_stream;
+	RGBWWLed*	rgbwwctrl;
 };
 
 
@@ -9,511 +9,436 @@
 #include "RGBWWLedColor.h"
 
 
-RGBWWColorUtils::RGBWWColorUtils() {
+/**************************************************************
+ *                     Color Config
+ **************************************************************/
+
+RGBWWColorConfig::RGBWWColorConfig() {
+	_refs = 1;
 	_colormode = RGBWWCW;
 	_hsvmodel = RAW;
-	_WarmWhiteKelvin = RGBWW_WARMWHITEKELVIN;
-	_ColdWhiteKelvin = RGBWW_COLDWHITEKELVIN;
+	setWhiteTemperature(RGBWW_WARMWHITEKELVIN, RGBWW_COLDWHITEKELVIN);
 	createHueWheel();
+	_hueMaps = RGBWWHueMaps::getDefault();
+	_hueMaps->acquire();
 	setBrightnessCorrection(100, 100, 100, 100, 100);
+	resetCalibrationMatrix();
+}
 
- }
+
+RGBWWColorConfig* RGBWWColorConfig::getDefault() {
+	// holds one reference for the lifetime of the program
+	static RGBWWColorConfig config;
+	return &config;
+}
+
+
+RGBWWColorConfig::~RGBWWColorConfig() {
+	_hueMaps->release();
+}
+
+
+void RGBWWColorConfig::release() {
+	if (--_refs == 0) {
+		delete this;
+	}
+}
+
+
+RGBWWColorConfig* RGBWWColorConfig::clone() const {
+	RGBWWColorConfig* config = new RGBWWColorConfig(*this);
+	config->_refs = 1;
+	config->_hueMaps->acquire();
+	return config;
+}
+
+
+RGBWWHueMaps* RGBWWColorConfig::editHueMaps() {
+	if (_hueMaps->getUsers() > 1) {
+		RGBWWHueMaps* maps = _hueMaps->clone();
+		_hueMaps->release();
+		_hueMaps = maps;
+	}
+	return _hueMaps;
+}
+
+
+void RGBWWColorConfig::setBrightnessCorrection(int r, int g, int b, int ww, int cw) {
+	_BrightnessFactor[RGBWW_CHANNELS::RED] = (constrain(r, 0, 100) * RGBWW_CALC_MAXVAL) / 100;
+	_BrightnessFactor[RGBWW_CHANNELS::GREEN] = (constrain(g, 0, 100) *  RGBWW_CALC_MAXVAL) / 100;
+	_BrightnessFactor[RGBWW_CHANNELS::BLUE] = (constrain(b, 0, 100) * RGBWW_CALC_MAXVAL) / 100;
+	_BrightnessFactor[RGBWW_CHANNELS::WW] = (constrain(ww, 0, 100) * RGBWW_CALC_MAXVAL) / 100;
+	_BrightnessFactor[RGBWW_CHANNELS::CW] = (constrain(cw, 0, 100) * RGBWW_CALC_MAXVAL) / 100;
+}
+
+
+void RGBWWColorConfig::setWhiteTemperature(int WarmWhite, int ColdWhite) {
+	_WarmWhiteKelvin = WarmWhite;
+	_ColdWhiteKelvin = ColdWhite;
+	_ColdWhiteMired = RGBWWColorUtils::kelvinToMired(ColdWhite);
+	int range = RGBWWColorUtils::kelvinToMired(WarmWhite) - _ColdWhiteMired;
+	// rounded up, so the warm white temperature results in RGBWW_CALC_MAXVAL
+	_MiredFactor = (range > 0) ? ((uint32_t(RGBWW_CALC_MAXVAL) << 16) + range - 1) / range : 0;
+}
+
+
+void RGBWWColorConfig::resetCalibrationMatrix() {
+	for (int i = 0; i < RGBWW_CHANNELS::NUM_CHANNELS; i++) {
+		for (int j = 0; j < RGBWW_CHANNELS::NUM_CHANNELS; j++) {
+			_CalibrationMatrix[i][j] = (i == j) ? RGBWW_CALIBRATION_ONE : 0;
+		}
+	}
+	_isCalibrated = false;
+}
+
+
+/**************************************************************
+ *                     Color Utils
+ **************************************************************/
+
+RGBWWColorUtils::RGBWWColorUtils() {
+	_config = RGBWWColorConfig::getDefault();
+	_config->acquire();
+	_generation = 1;
+	_cache.generation = 0;
+	resetCacheStats();
+}
+
+
+RGBWWColorUtils::RGBWWColorUtils(const RGBWWColorUtils& other) {
+	_config = other._config;
+	_config->acquire();
+	_generation = 1;
+	_cache.generation = 0;
+	resetCacheStats();
+}
+
+
+RGBWWColorUtils& RGBWWColorUtils::operator=(const RGBWWColorUtils& other) {
+	shareConfig(other);
+	return *this;
+}
+
+
+RGBWWColorUtils::~RGBWWColorUtils() {
+	_config->release();
+}
+
+
+void RGBWWColorUtils::shareConfig(const RGBWWColorUtils& other) {
+	if (_config == other._config) return;
+	other._config->acquire();
+	_config->release();
+	_config = other._config;
+	_generation++;
+}
+
+
+/*
+ * Returns the configuration for modification
+ * copies it first if it is used by other instances
+ */
+RGBWWColorConfig* RGBWWColorUtils::editConfig() {
+	if (_config->getUsers() > 1) {
+		RGBWWColorConfig* config = _config->clone();
+		_config->release();
+		_config = config;
+	}
+	_generation++;
+	return _config;
+}
 
 
 void RGBWWColorUtils::setColorMode(RGBWW_COLORMODE mode) {
 	debugRGBW("COLORMODE %i", mode);
-	_colormode = mode;
+	editConfig()->_colormode = mode;
 }
 
 
 RGBWW_COLORMODE RGBWWColorUtils::getColorMode() {
-	debugRGBW("COLORMODE %i", _colormode);
-	return _colormode;
+	debugRGBW("COLORMODE %i", _config->_colormode);
+	return _config->_colormode;
 }
 
 
 void RGBWWColorUtils::setHSVmodel(RGBWW_HSVMODEL model) {
 	debugRGBW("HSVMODE %i", model);
-	_hsvmodel = model;
+	editConfig()->_hsvmodel = model;
 }
 
 
 RGBWW_HSVMODEL RGBWWColorUtils::getHSVmodel() {
-	debugRGBW("HSVMODE %i", _hsvmodel);
-	return _hsvmodel;
+	debugRGBW("HSVMODE %i", _config->_hsvmodel);
+	return _config->_hsvmodel;
 }
 
 
 void RGBWWColorUtils::setWhiteTemperature(int WarmWhite, int ColdWhite) {
-	_WarmWhiteKelvin = WarmWhite;
-	_ColdWhiteKelvin = ColdWhite;
+	editConfig()->setWhiteTemperature(WarmWhite, ColdWhite);
 }
 
 
 void RGBWWColorUtils::getWhiteTemperature(int& WarmWhite, int& ColdWhite) {
-	WarmWhite = _WarmWhiteKelvin;
-	ColdWhite = _ColdWhiteKelvin;
+	WarmWhite = _config->_WarmWhiteKelvin;
+	ColdWhite = _config->_ColdWhiteKelvin;
 }
 
 
 void RGBWWColorUtils::setBrightnessCorrection(int r, int g, int b, int ww, int cw) {
-	_BrightnessFactor[RGBWW_CHANNELS::RED] = (constrain(r, 0, 100) * RGBWW_CALC_MAXVAL) / 100;
-	_BrightnessFactor[RGBWW_CHANNELS::GREEN] = (constrain(g, 0, 100) *  RGBWW_CALC_MAXVAL) / 100;
-	_BrightnessFactor[RGBWW_CHANNELS::BLUE] = (constrain(b, 0, 100) * RGBWW_CALC_MAXVAL) / 100;
-	_BrightnessFactor[RGBWW_CHANNELS::WW] = (constrain(ww, 0, 100) * RGBWW_CALC_MAXVAL) / 100;
-	_BrightnessFactor[RGBWW_CHANNELS::CW] = (constrain(cw, 0, 100) * RGBWW_CALC_MAXVAL) / 100;
-
-};
+	editConfig()->setBrightnessCorrection(r, g, b, ww, cw);
+}
 
 
 void RGBWWColorUtils::getBrightnessCorrection(int& r, int& g, int& b, int& ww, int& cw) {
-	r = (_BrightnessFactor[RGBWW_CHANNELS::RED] * 100) / RGBWW_CALC_MAXVAL;
-	g = (_BrightnessFactor[RGBWW_CHANNELS::GREEN] * 100) / RGBWW_CALC_MAXVAL;
-	b = (_BrightnessFactor[RGBWW_CHANNELS::BLUE] * 100) / RGBWW_CALC_MAXVAL;
-	ww = (_BrightnessFactor[RGBWW_CHANNELS::WW] * 100) / RGBWW_CALC_MAXVAL;
-	cw = (_BrightnessFactor[RGBWW_CHANNELS::CW] * 100) / RGBWW_CALC_MAXVAL;
+	const int* factor = _config->_BrightnessFactor;
+	r = (factor[RGBWW_CHANNELS::RED] * 100) / RGBWW_CALC_MAXVAL;
+	g = (factor[RGBWW_CHANNELS::GREEN] * 100) / RGBWW_CALC_MAXVAL;
+	b = (factor[RGBWW_CHANNELS::BLUE] * 100) / RGBWW_CALC_MAXVAL;
+	ww = (factor[RGBWW_CHANNELS::WW] * 100) / RGBWW_CALC_MAXVAL;
+	cw = (factor[RGBWW_CHANNELS::CW] * 100) / RGBWW_CALC_MAXVAL;
 }
 
 
 
 void RGBWWColorUtils::correctBrightness(ChannelOutput& output) {
-	output.red = (output.red * _BrightnessFactor[RGBWW_CHANNELS::RED]) / RGBWW_CALC_MAXVAL;
-	output.green = (output.green * _BrightnessFactor[RGBWW_CHANNELS::GREEN]) / RGBWW_CALC_MAXVAL;
-	output.blue = (output.blue * _BrightnessFactor[RGBWW_CHANNELS::BLUE]) / RGBWW_CALC_MAXVAL;
-	output.warmwhite = (output.warmwhite * _BrightnessFactor[RGBWW_CHANNELS::WW]) / RGBWW_CALC_MAXVAL;
-	output.coldwhite = (output.coldwhite * _BrightnessFactor[RGBWW_CHANNELS::CW]) / RGBWW_CALC_MAXVAL;
+	const int* factor = _config->_BrightnessFactor;
+	output.red = (RGBWW_CALC_WIDE(output.red) * factor[RGBWW_CHANNELS::RED]) / RGBWW_CALC_MAXVAL;
+	output.green = (RGBWW_CALC_WIDE(output.green) * factor[RGBWW_CHANNELS::GREEN]) / RGBWW_CALC_MAXVAL;
+	output.blue = (RGBWW_CALC_WIDE(output.blue) * factor[RGBWW_CHANNELS::BLUE]) / RGBWW_CALC_MAXVAL;
+	output.warmwhite = (RGBWW_CALC_WIDE(output.warmwhite) * factor[RGBWW_CHANNELS::WW]) / RGBWW_CALC_MAXVAL;
+	output.coldwhite = (RGBWW_CALC_WIDE(output.coldwhite) * factor[RGBWW_CHANNELS::CW]) / RGBWW_CALC_MAXVAL;
+}
+
+
+void RGBWWColorUtils::setCalibrationMatrix(const int matrix[RGBWW_CHANNELS::NUM_CHANNELS][RGBWW_CHANNELS::NUM_CHANNELS]) {
+	RGBWWColorConfig* config = editConfig();
+	config->_isCalibrated = false;
+	for (int i = 0; i < RGBWW_CHANNELS::NUM_CHANNELS; i++) {
+		for (int j = 0; j < RGBWW_CHANNELS::NUM_CHANNELS; j++) {
+			config->_CalibrationMatrix[i][j] = constrain(matrix[i][j], -32768, 32767);
+			if (config->_CalibrationMatrix[i][j] != ((i == j) ? RGBWW_CALIBRATION_ONE : 0)) {
+				config->_isCalibrated = true;
+			}
+		}
+	}
+}
+
+
+void RGBWWColorUtils::getCalibrationMatrix(int matrix[RGBWW_CHANNELS::NUM_CHANNELS][RGBWW_CHANNELS::NUM_CHANNELS]) {
+	for (int i = 0; i < RGBWW_CHANNELS::NUM_CHANNELS; i++) {
+		for (int j = 0; j < RGBWW_CHANNELS::NUM_CHANNELS; j++) {
+			matrix[i][j] = _config->_CalibrationMatrix[i][j];
+		}
+	}
+}
+
+
+void RGBWWColorUtils::resetCalibrationMatrix() {
+	editConfig()->resetCalibrationMatrix();
+}
+
+
+void RGBWWColorUtils::calibrate(ChannelOutput& output) {
+	// identity matrix - nothing to do
+	if (!_config->_isCalibrated) return;
+
+	const int in[RGBWW_CHANNELS::NUM_CHANNELS] = { output.r, output.g, output.b, output.ww, output.cw };
+	int out[RGBWW_CHANNELS::NUM_CHANNELS];
+	for (int i = 0; i < RGBWW_CHANNELS::NUM_CHANNELS; i++) {
+		const int16_t* row = _config->_CalibrationMatrix[i];
+		RGBWW_CALIBRATION_ACC sum = RGBWW_CALIBRATION_ONE / 2; // round to nearest
+		sum += RGBWW_CALIBRATION_ACC(row[0]) * in[0];
+		sum += RGBWW_CALIBRATION_ACC(row[1]) * in[1];
+		sum += RGBWW_CALIBRATION_ACC(row[2]) * in[2];
+		sum += RGBWW_CALIBRATION_ACC(row[3]) * in[3];
+		sum += RGBWW_CALIBRATION_ACC(row[4]) * in[4];
+		sum >>= RGBWW_CALIBRATION_SHIFT;
+		out[i] = int(constrain(sum, 0, RGBWW_CALC_MAXVAL));
+	}
+	output.r = out[RGBWW_CHANNELS::RED];
+	output.g = out[RGBWW_CHANNELS::GREEN];
+	output.b = out[RGBWW_CHANNELS::BLUE];
+	output.ww = out[RGBWW_CHANNELS::WW];
+	output.cw = out[RGBWW_CHANNELS::CW];
 }
 
 
 void RGBWWColorUtils::setHSVcorrection(float red, float yellow, float green, float cyan, float blue, float magenta) {
 	// reset color wheel before applying any changes
 	// otherwise we apply changes to any previous colorwheel
-	createHueWheel();
+	RGBWWColorConfig* config = editConfig();
+	config->createHueWheel();
 
 	//correct sector 1
-	_HueWheelSectorWidth[0] -= parseColorCorrection(red);
-	_HueWheelSectorWidth[0] += parseColorCorrection(yellow);
-	_HueWheelSector[1] += parseColorCorrection(yellow);
+	config->_HueWheelSectorWidth[0] -= parseColorCorrection(red);
+	config->_HueWheelSectorWidth[0] += parseColorCorrection(yellow);
+	config->_HueWheelSector[1] += parseColorCorrection(yellow);
 
 	//correct sector 2
-	_HueWheelSectorWidth[1] -= parseColorCorrection(yellow);
-	_HueWheelSectorWidth[1] += parseColorCorrection(green);
-	_HueWheelSector[2] += parseColorCorrection(green);
+	config->_HueWheelSectorWidth[1] -= parseColorCorrection(yellow);
+	config->_HueWheelSectorWidth[1] += parseColorCorrection(green);
+	config->_HueWheelSector[2] += parseColorCorrection(green);
 
 	//correct sector 3
-	_HueWheelSectorWidth[2] -= parseColorCorrection(green);
-	_HueWheelSectorWidth[2] += parseColorCorrection(cyan);
-	_HueWheelSector[3] += parseColorCorrection(cyan);
+	config->_HueWheelSectorWidth[2] -= parseColorCorrection(green);
+	config->_HueWheelSectorWidth[2] += parseColorCorrection(cyan);
+	config->_HueWheelSector[3] += parseColorCorrection(cyan);
 
 	//correct sector 4
-	_HueWheelSectorWidth[3] -= parseColorCorrection(cyan);
-	_HueWheelSectorWidth[3] += parseColorCorrection(blue);
-	_HueWheelSector[4] += parseColorCorrection(blue);
+	config->_HueWheelSectorWidth[3] -= parseColorCorrection(cyan);
+	config->_HueWheelSectorWidth[3] += parseColorCorrection(blue);
+	config->_HueWheelSector[4] += parseColorCorrection(blue);
 
 	//correct sector 5
-	_HueWheelSectorWidth[4] -= parseColorCorrection(blue);
-	_HueWheelSectorWidth[4] += parseColorCorrection(magenta);
-	_HueWheelSector[5] += parseColorCorrection(magenta);
+	config->_HueWheelSectorWidth[4] -= parseColorCorrection(blue);
+	config->_HueWheelSectorWidth[4] += parseColorCorrection(magenta);
+	config->_HueWheelSector[5] += parseColorCorrection(magenta);
 
 	//correct sector 6
-	_HueWheelSectorWidth[5] -= parseColorCorrection(magenta);
-	_HueWheelSectorWidth[5] += parseColorCorrection(red);
-	_HueWheelSector[6] += parseColorCorrection(red);
-	_HueWheelSector[0] += parseColorCorrection(red);
+	config->_HueWheelSectorWidth[5] -= parseColorCorrection(magenta);
+	config->_HueWheelSectorWidth[5] += parseColorCorrection(red);
+	config->_HueWheelSector[6] += parseColorCorrection(red);
+	config->_HueWheelSector[0] += parseColorCorrection(red);
 
+	config->editHueMaps()->create(config->_HueWheelSector);
 }
 
 
 void RGBWWColorUtils::getHSVcorrection(float& red, float& yellow, float& green, float& cyan, float& blue, float& magenta) {
-	red = -1 * (float(_HueWheelSector[6] - 6* RGBWW_CALC_MAXVAL)/ float(RGBWW_CALC_MAXVAL)) * 60.0;
-	yellow = -1 * (float(_HueWheelSector[1] - 1* RGBWW_CALC_MAXVAL)/ float(RGBWW_CALC_MAXVAL)) * 60.0;
-	green = -1 * (float(_HueWheelSector[2] - 2* RGBWW_CALC_MAXVAL)/ float(RGBWW_CALC_MAXVAL)) * 60.0;
-	cyan = -1 * (float(_HueWheelSector[3] - 3* RGBWW_CALC_MAXVAL)/ float(RGBWW_CALC_MAXVAL)) * 60.0;
-	blue = -1 * (float(_HueWheelSector[4] - 4* RGBWW_CALC_MAXVAL)/ float(RGBWW_CALC_MAXVAL)) * 60.0;
-	magenta = -1 * (float(_HueWheelSector[5] - 5* RGBWW_CALC_MAXVAL)/ float(RGBWW_CALC_MAXVAL)) * 60.0;
+	const int* sector = _config->_HueWheelSector;
+	red = -1 * (float(sector[6] - 6* RGBWW_CALC_MAXVAL)/ float(RGBWW_CALC_MAXVAL)) * 60.0;
+	yellow = -1 * (float(sector[1] - 1* RGBWW_CALC_MAXVAL)/ float(RGBWW_CALC_MAXVAL)) * 60.0;
+	green = -1 * (float(sector[2] - 2* RGBWW_CALC_MAXVAL)/ float(RGBWW_CALC_MAXVAL)) * 60.0;
+	cyan = -1 * (float(sector[3] - 3* RGBWW_CALC_MAXVAL)/ float(RGBWW_CALC_MAXVAL)) * 60.0;
+	blue = -1 * (float(sector[4] - 4* RGBWW_CALC_MAXVAL)/ float(RGBWW_CALC_MAXVAL)) * 60.0;
+	magenta = -1 * (float(sector[5] - 5* RGBWW_CALC_MAXVAL)/ float(RGBWW_CALC_MAXVAL)) * 60.0;
 
 }
 
 
  void RGBWWColorUtils::whiteBalance(RGBWCT& rgbw, ChannelOutput& output) {
-	/*
-	 * White balance will only be done on the w part
-	 * - a calibration is needed in order to be able to calculate the parts of
-	 * red/green/blue for calculating color temperatur
-	 *
-	 * color temperature will only be calculated for the "white part" in rgb
-	 * due to differences between led types, manufacturers and also different
-	 * (perceived) output levels with pwm and for different colors this is more
-	 * an estimation and should never be taken as a professional calculation
-	 *
-	 */
-	output.r = rgbw.r;
-	output.g = rgbw.g;
-	output.b = rgbw.b;
-	switch(_colormode) {
+	switch(_config->_colormode) {
 	case RGBWWCW:
-		if (_WarmWhiteKelvin <= rgbw.ct && _ColdWhiteKelvin >= rgbw.ct) {
-			int wwfactor = ((_ColdWhiteKelvin - rgbw.ct) * RGBWW_CALC_MAXVAL) /  (_ColdWhiteKelvin - _WarmWhiteKelvin);
-			//balance between CW and WW Leds
-			output.warmwhite = (rgbw.w * wwfactor) /RGBWW_CALC_MAXVAL;
-			output.coldwhite = (rgbw.w * (1 - wwfactor)) / RGBWW_CALC_MAXVAL;
-		} else {
-			// if kelvin outside range - different calculation algorithm
-			// for now we asume a "neutral white" (0.5 CW, 0.5 WW)
-			output.warmwhite = rgbw.w/2;
-			output.coldwhite = rgbw.w/2;
-		}
-		break;
+		whiteBalance<RGBWWCW>(rgbw, output); break;
 	case RGBCW:
-		//TODO implement valid algorithm
-
-		output.warmwhite = 0;
-		output.coldwhite = rgbw.w;
-		break;
-
+		whiteBalance<RGBCW>(rgbw, output); break;
 	case RGBWW:
-		//TODO implement valid algorithm
-		output.warmwhite = rgbw.w;
-		output.coldwhite = 0;
-		break;
-
-	case RGB:
-		//TODO implement valid algorithm
-		output.r += rgbw.w;
-		output.g += rgbw.w;
-		output.b += rgbw.w;
-		output.coldwhite = 0;
-		output.warmwhite = 0;
-		break;
+		whiteBalance<RGBWW>(rgbw, output); break;
+	default:
+		whiteBalance<RGB>(rgbw, output); break;
 	}
  }
 
 
-void RGBWWColorUtils::HSVtoRGB(const HSVCT& hsvk, RGBWCT& rgbwk) {
-	HSVtoRGB(hsvk, rgbwk, _hsvmodel);
+inline void RGBWWColorUtils::applyHueFactors(const HSVCT& hsvk, const int* factor, RGBWCT& rgbwk) {
+	// m equals the white part
+	// for rgbw we use it for the white channels
+	int chroma = (RGBWW_CALC_WIDE(hsvk.s) * hsvk.v) / RGBWW_CALC_MAXVAL;
+	rgbwk.r = scaleChroma(chroma, factor[0]);
+	rgbwk.g = scaleChroma(chroma, factor[1]);
+	rgbwk.b = scaleChroma(chroma, factor[2]);
+	rgbwk.w = hsvk.v - chroma;
+	rgbwk.ct = hsvk.ct;
 }
 
 
-void RGBWWColorUtils::HSVtoRGB(const HSVCT& hsvk, RGBWCT& rgbwk, RGBWW_HSVMODEL mode) {
-
-	switch(mode) {
-		case SPEKTRUM: {
-			HSVtoRGBspektrum(hsvk, rgbwk); break;
-		}
-		case RAINBOW: {
-			// TODO: transform normal HUE range to rainbowHue range
-			// map 0 - 60 to 0-90
-			// map 60 - 120 to 90 - 135
-			// map 120 - 180 to 135 - 180
-			// map 180 - 240 to 180 - 225
-			// map 240 - 300 to 225 - 270
-			// map 300 - 360 to 270 - 360
-			HSVtoRGBrainbow(hsvk, rgbwk); break;
-		}
-		default: {
-			HSVtoRGBraw(hsvk, rgbwk); break;
+void RGBWWColorUtils::HSVtoOutput(const HSVCT& hsvk, ChannelOutput& output) {
+	RGBWW_PROFILE_BEGIN(PROFILE_HSVTORGB);
+	if (_cache.generation == _generation && _cache.hsv.h == hsvk.h &&
+			_cache.hsv.s == hsvk.s && _cache.hsv.ct == hsvk.ct) {
+		if (_cache.hsv.v == hsvk.v) {
+			_cacheHits++;
+			output = _cache.output;
+			RGBWW_PROFILE_END(PROFILE_HSVTORGB);
+			return;
 		}
+		// only the value changed - rescale chroma and white part
+		_cacheScaled++;
+	} else {
+		_cacheMisses++;
+		_cache.generation = _generation;
+		_cache.hsv.h = hsvk.h;
+		_cache.hsv.s = hsvk.s;
+		_cache.hsv.ct = hsvk.ct;
+		_config->hueMap(_config->_hsvmodel).evaluate(hsvk.h, _cache.factor);
 	}
-
+	_cache.hsv.v = hsvk.v;
+	applyHueFactors(hsvk, _cache.factor, _cache.rgbw);
+	RGBWW_PROFILE_END(PROFILE_HSVTORGB);
+	RGBWW_PROFILE_BEGIN(PROFILE_WHITEBALANCE);
+	whiteBalance(_cache.rgbw, _cache.output);
+	RGBWW_PROFILE_END(PROFILE_WHITEBALANCE);
+	output = _cache.output;
 }
 
 
+void RGBWWColorUtils::getCacheStats(uint32_t& hits, uint32_t& scaled, uint32_t& misses) {
+	hits = _cacheHits;
+	scaled = _cacheScaled;
+	misses = _cacheMisses;
+}
 
 
-// Method is based one the method from FASTLed
-// https://github.com/FastLED/FastLED/wiki/FastLED-HSV-Colors#color-map-rainbow-vs-spectrum
-// https://github.com/FastLED/FastLED/blob/master/colorutils.h
-//
-#define rainbow_third int(RGBWW_CALC_MAXVAL / 3)
-#define rainbow_two_third int(rainbow_third *2)
-#define rainbow_sector_width int (RGBWW_CALC_HUEWHEELMAX / 8)
-
-void RGBWWColorUtils::HSVtoRGBrainbow(const HSVCT& hsvk, RGBWCT& rgbwk) {
-	int val, hue, sat, r, g, b, chroma, m, sector;
+void RGBWWColorUtils::resetCacheStats() {
+	_cacheHits = 0;
+	_cacheScaled = 0;
+	_cacheMisses = 0;
+}
 
-	hue = hsvk.h;
-	val = hsvk.v;
-	sat = hsvk.s;
-	//gamma correction
-	//val = RGBWW_dim_curve[hsvk.v];
-	//sat = RGBWW_PWMMAXVAL - RGBWW_dim_curve[RGBWW_PWMMAXVAL-sat];
 
-	if(sat == 0) {
-		// color is grayscale
-		rgbwk.r = 0;
-		rgbwk.g = 0;
-		rgbwk.b = 0;
-		rgbwk.w = val;
-	} else {
-		chroma = (sat * val) / RGBWW_CALC_MAXVAL;
-		m = val - chroma;
-
-		sector = hue / rainbow_sector_width;
-		hue = hue - sector * rainbow_sector_width;
-
-		if (sector < 4) {
-			//sector 0 - 3
-			if(sector < 1) {
-				// red - > orange
-				debugRGBW("HSVtoRGBrainbow sector 0");
-				r = (chroma * (RGBWW_CALC_MAXVAL -  (rainbow_third * hue) / rainbow_sector_width  )) / RGBWW_CALC_MAXVAL;
-				g = (chroma * ((rainbow_third * hue) / rainbow_sector_width  )) / RGBWW_CALC_MAXVAL;
-				b = 0;
-			} else if(sector < 2) {
-				// orange -> yellow
-				debugRGBW("HSVtoRGBrainbow sector 1");
-				r = (chroma * (rainbow_two_third )) / RGBWW_CALC_MAXVAL;
-				g = (chroma * (rainbow_third + (rainbow_third * hue) / rainbow_sector_width )) / RGBWW_CALC_MAXVAL;
-				b = 0;
-			} else if(sector < 3) {
-				// yellow -> green
-				debugRGBW("HSVtoRGBrainbow sector 2");
-				r = (chroma * (rainbow_two_third - (rainbow_two_third * hue) / rainbow_sector_width )) / RGBWW_CALC_MAXVAL;
-				g = (chroma * (rainbow_two_third + (rainbow_third * hue) / rainbow_sector_width )) / RGBWW_CALC_MAXVAL;
-				b = 0;
-			} else {
-				// green ->  aqua
-				debugRGBW("HSVtoRGBrainbow sector 3");
-				r = 0;
-				g = (chroma * (RGBWW_CALC_MAXVAL -  (rainbow_third * hue) / rainbow_sector_width)) / RGBWW_CALC_MAXVAL;
-				b = (chroma * ((rainbow_third * hue) / rainbow_sector_width)) / RGBWW_CALC_MAXVAL;
-			}
-		} else {
-			//sector 4 - 7
-			if(sector < 5) {
-				// aqua -> blue
-				debugRGBW("HSVtoRGBrainbow sector 4");
-				r = 0;
-				g = (chroma * (rainbow_two_third - (rainbow_two_third * hue) / rainbow_sector_width)) / RGBWW_CALC_MAXVAL;
-				b = (chroma * (rainbow_third + (rainbow_two_third * hue) / rainbow_sector_width)) / RGBWW_CALC_MAXVAL;
-			} else if(sector < 6) {
-				// blue -> purple
-				debugRGBW("HSVtoRGBrainbow sector 5");
-				r = (chroma * ((rainbow_third * hue) / rainbow_sector_width)) / RGBWW_CALC_MAXVAL;
-				g = 0;
-				b = (chroma * (RGBWW_CALC_MAXVAL -  (rainbow_third * hue) / rainbow_sector_width)) / RGBWW_CALC_MAXVAL;
-			} else if(sector < 7) {
-				// purple -> pink
-				debugRGBW("HSVtoRGBrainbow sector 6");
-				r = (chroma * (rainbow_third + (rainbow_third * hue) / rainbow_sector_width)) / RGBWW_CALC_MAXVAL;
-				g = 0;
-				b = (chroma * (rainbow_two_third - (rainbow_third * hue) / rainbow_sector_width)) / RGBWW_CALC_MAXVAL;
-			} else {
-				// pink -> red
-				debugRGBW("HSVtoRGBrainbow sector 7");
-				r = (chroma * (rainbow_two_third + (rainbow_third * hue) / rainbow_sector_width)) / RGBWW_CALC_MAXVAL;
-				g = 0;
-				b = (chroma * (rainbow_third - (rainbow_third * hue) / rainbow_sector_width)) / RGBWW_CALC_MAXVAL;
-			}
-		}
-		rgbwk.r = r;
-		rgbwk.g = g;
-		rgbwk.b = b;
-		rgbwk.w = m;
-	}
-	debugRGBW("HSVtoRGBrainbow R %i | G %i | B %i | W %i", rgbwk.r, rgbwk.g, rgbwk.b, rgbwk.w);
+void RGBWWColorUtils::HSVtoRGB(const HSVCT& hsvk, RGBWCT& rgbwk) {
+	HSVtoRGB(hsvk, rgbwk, _config->_hsvmodel);
 }
 
 
-void RGBWWColorUtils::HSVtoRGBspektrum(const HSVCT& hsvk, RGBWCT& rgbwk) {
-	int val, hue, sat, r, g, b, fract, chroma, half_chroma, m;
+void RGBWWColorUtils::HSVtoRGB(const HSVCT& hsvk, RGBWCT& rgbwk, RGBWW_HSVMODEL mode) {
+	HSVtoRGBmap(hsvk, rgbwk, _config->hueMap(mode));
+}
 
-	hue = hsvk.h;
-	val = hsvk.v;
-	sat = hsvk.s;
-	//gamma correction
-	//val = RGBWW_dim_curve[hsvk.v];
-	//sat = RGBWW_PWMMAXVAL - RGBWW_dim_curve[RGBWW_PWMMAXVAL-sat];
 
-	if(sat == 0) {
+void RGBWWColorUtils::HSVtoRGBmap(const HSVCT& hsvk, RGBWCT& rgbwk, const RGBWWHueMap& map) {
+	int factor[3];
+	if (hsvk.s == 0) {
 		// color is grayscale
-		rgbwk.r = 0;
-		rgbwk.g = 0;
-		rgbwk.b = 0;
-		rgbwk.w = val;
+		factor[0] = 0;
+		factor[1] = 0;
+		factor[2] = 0;
 	} else {
-		chroma = (sat * val) / RGBWW_CALC_MAXVAL;
-		half_chroma = chroma >> 1;
-		m = val - chroma;
-		if ( hue < _HueWheelSector[0] || (hue > _HueWheelSector[5] && hue <= _HueWheelSector[6])) {
-			debugRGBW("HSVtoRGBspektrum Sector 6");
-			if (hue < _HueWheelSector[0]) {
-				fract = RGBWW_CALC_MAXVAL + hue ;
-			} else {
-				fract = hue - _HueWheelSector[5];
-			}
-			fract = ( half_chroma * ((RGBWW_CALC_MAXVAL * fract) / _HueWheelSectorWidth[5])) / RGBWW_CALC_MAXVAL;
-			r = half_chroma + fract;
-			g = 0;
-			b = half_chroma - fract;
-
-		} else if (  hue <= _HueWheelSector[1]  || hue > _HueWheelSector[6]) {
-			// Sector 1
-			debugRGBW("HSVtoRGBspektrum Sector 1");
-			if (hue > _HueWheelSector[6]) {
-				fract = hue - _HueWheelSector[6];
-			} else {
-				fract = hue + (RGBWW_CALC_HUEWHEELMAX - _HueWheelSector[6]);
-			}
-			fract = (half_chroma * ((RGBWW_CALC_MAXVAL * fract) / _HueWheelSectorWidth[0])) / RGBWW_CALC_MAXVAL;
-			r = chroma - fract;
-			g = fract;
-			b = 0;
-
-		} else if (hue <= _HueWheelSector[2]) {
-			// Sector 2
-			debugRGBW("HSVtoRGBspektrum Sector 2");
-			fract = hue - _HueWheelSector[1];
-			fract = (half_chroma * ((RGBWW_CALC_MAXVAL * fract) / _HueWheelSectorWidth[1])) / RGBWW_CALC_MAXVAL ;
-			r = half_chroma - fract;
-			g = half_chroma + fract;
-			b = 0;
-
-		} else if (hue <= _HueWheelSector[3]) {
-			// Sector 3
-			debugRGBW("HSVtoRGBspektrum Sector 3");
-			fract = hue - _HueWheelSector[2];
-			fract = (half_chroma * ((RGBWW_CALC_MAXVAL * fract) / _HueWheelSectorWidth[2])) / RGBWW_CALC_MAXVAL;
-			r = 0;
-			g = chroma - fract;
-			b = fract;
-
-		} else if (hue <= _HueWheelSector[4]) {
-			// Sector 4
-			debugRGBW("HSVtoRGBspektrum Sector 4");
-			fract = hue - _HueWheelSector[3];
-			fract = (half_chroma * ((RGBWW_CALC_MAXVAL * fract) / _HueWheelSectorWidth[3])) / RGBWW_CALC_MAXVAL;
-			r = 0;
-			g = half_chroma - fract;
-			b = half_chroma + fract;
-
-		} else  {
-			// Sector 5
-			debugRGBW("HSVtoRGBspektrum Sector 5");
-			fract = hue - _HueWheelSector[4];
-			fract = (half_chroma * ((RGBWW_CALC_MAXVAL * fract) / _HueWheelSectorWidth[4])) / RGBWW_CALC_MAXVAL;
-			r = fract;
-			g = 0;
-			b = chroma - fract;
-
-		}
-		rgbwk.r = r;
-		rgbwk.g = g;
-		rgbwk.b = b;
-		rgbwk.w = m;
+		map.evaluate(hsvk.h, factor);
 	}
-	debugRGBW("HSVtoRGBspektrum R %i | G %i | B %i | W %i", rgbwk.r, rgbwk.g, rgbwk.b, rgbwk.w);
-
+	applyHueFactors(hsvk, factor, rgbwk);
+	traceRGBW(TRACE_HSVTORGB, rgbwk.r, rgbwk.g, rgbwk.b, rgbwk.w);
 }
 
 
-
 void RGBWWColorUtils::HSVtoRGBraw(const HSVCT& hsvk, RGBWCT& rgbwk) {
-	int val, hue, sat, r, g, b, fract, chroma, m;
-
-	hue = hsvk.h;
-	val = hsvk.v;
-	sat = hsvk.s;
-	//gamma correction
-	//val = RGBWW_dim_curve[hsvk.v];
-	//sat = RGBWW_PWMMAXVAL - RGBWW_dim_curve[RGBWW_PWMMAXVAL-sat];
+	HSVtoRGBmap(hsvk, rgbwk, _config->hueMap(RAW));
+}
 
-	rgbwk.ct = hsvk.ct;
 
+void RGBWWColorUtils::HSVtoRGBspektrum(const HSVCT& hsvk, RGBWCT& rgbwk) {
+	HSVtoRGBmap(hsvk, rgbwk, _config->hueMap(SPEKTRUM));
+}
 
-	if(sat == 0) {
-		/* color is grayscale */
-		rgbwk.r = 0;
-		rgbwk.g = 0;
-		rgbwk.b = 0;
-		rgbwk.w = val;
 
+void RGBWWColorUtils::HSVtoRGBrainbow(const HSVCT& hsvk, RGBWCT& rgbwk) {
+	HSVtoRGBmap(hsvk, rgbwk, _config->hueMap(RAINBOW));
+}
 
-	} else {
-		/*
-         * We have 6 sectors
-         * We need 7 "borders" to incorporate the shift oft sectors
-         *
-         * Example: 8bit values
-         * Sector 1 is from 0 - 255. We need border 0 as lower border, 255 as upper border.
-         * Sector 6 is from 1275 - 1530. Lower border 1275, upper border 1530
-		 *
-         * Apply a color correct for red with +10deg (value 25) results in
-         * Sector 1 from 0 - 255 & 1505 - 1530
-         * Sector 6 from 1275 - 1505
-
-         * Apply a color correct for red with -10deg (value 25) results in
-         * Sector 1 from 25 - 255
-         * Sector 6 from 1275 - 1530 && 0 - 25
-		 */
-		chroma = (sat * val) / RGBWW_CALC_MAXVAL;
-		m = val - chroma;
-		if ( hue < _HueWheelSector[0] || (hue > _HueWheelSector[5] && hue <= _HueWheelSector[6])) {
-			debugRGBW("HSVtoRGBraw Sector 6");
-			if (hue < _HueWheelSector[0]) {
-				fract = RGBWW_CALC_MAXVAL + hue ;
-			} else {
-				fract = hue - _HueWheelSector[5];
-			}
 
-			r = chroma;
-			g = 0;
-			b = ( chroma * (RGBWW_CALC_MAXVAL - (RGBWW_CALC_MAXVAL * fract) / _HueWheelSectorWidth[5])) / RGBWW_CALC_MAXVAL;
-
-		} else if (  hue <= _HueWheelSector[1]  || hue > _HueWheelSector[6]) {
-			// Sector 1
-			debugRGBW("HSVtoRGBraw Sector 1");
-			if (hue > _HueWheelSector[6]) {
-				fract = hue - _HueWheelSector[6];
-			} else {
-				fract = hue + (RGBWW_CALC_HUEWHEELMAX - _HueWheelSector[6]);
-			}
-			r = chroma;
-			g = (chroma * ((RGBWW_CALC_MAXVAL * fract) / _HueWheelSectorWidth[0])) / RGBWW_CALC_MAXVAL;
-			b = 0;
-
-		} else if (hue <= _HueWheelSector[2]) {
-			// Sector 2
-			debugRGBW("HSVtoRGBraw Sector 2");
-			fract = hue - _HueWheelSector[1];
-			r = (chroma * (RGBWW_CALC_MAXVAL - (RGBWW_CALC_MAXVAL * fract) / _HueWheelSectorWidth[1])) / RGBWW_CALC_MAXVAL;
-			g = chroma;
-			b = 0;
-
-		} else if (hue <= _HueWheelSector[3]) {
-			// Sector 3
-			debugRGBW("HSVtoRGBraw Sector 3");
-			fract = hue - _HueWheelSector[2];
-			r = 0;
-			g = chroma;
-			b = (chroma * ((RGBWW_CALC_MAXVAL * fract) / _HueWheelSectorWidth[2])) / RGBWW_CALC_MAXVAL;
-
-		} else if (hue <= _HueWheelSector[4]) {
-			// Sector 4
-			debugRGBW("HSVtoRGBraw Sector 4");
-			fract = hue - _HueWheelSector[3];
-			r = 0;
-			g =(chroma * (RGBWW_CALC_MAXVAL - (RGBWW_CALC_MAXVAL * fract) / _HueWheelSectorWidth[3])) / RGBWW_CALC_MAXVAL;
-			b = chroma;
-
-		} else  {
-			// Sector 5
-			debugRGBW("HSVtoRGBraw Sector 5");
-			fract = hue - _HueWheelSector[4];
-			r = (chroma * ((RGBWW_CALC_MAXVAL * fract) / _HueWheelSectorWidth[4])) / RGBWW_CALC_MAXVAL;
-			g = 0;
-			b = chroma;
+bool RGBWWColorUtils::setHueMap(const RGBWWHueMapPoint* points, int count) {
+	// validate before the configuration gets copied
+	RGBWWHueMap map;
+	if (!map.set(points, count)) {
+		return false;
+	}
+	editConfig()->editHueMaps()->_maps[CUSTOM] = map;
+	return true;
+}
 
-		}
-		// m equals the white part
-		// for rgbw we use it for the white channels
-		rgbwk.r = r;
-		rgbwk.g = g;
-		rgbwk.b = b;
-		rgbwk.w = m;
 
-	}
-	debugRGBW("HSVtoRGBraw R %i | G %i | B %i | W %i", rgbwk.r, rgbwk.g, rgbwk.b, rgbwk.w);
+int RGBWWColorUtils::getHueMap(RGBWW_HSVMODEL model, RGBWWHueMapPoint* points) {
+	return _config->hueMap(model).get(points);
 }
 
 
@@ -527,7 +452,7 @@ void  RGBWWColorUtils::RGBtoHSV(const RGBWCT& rgbw, HSVCT& hsv) {
 /*
  * Helper function to create the 6 sectors for the HUE wheel
  */
-void RGBWWColorUtils::createHueWheel() {
+void RGBWWColorConfig::createHueWheel() {
 	_HueWheelSector[0] = 0;
 	for (int i = 1; i <= 6; ++i) {
 		_HueWheelSector[i] = i*RGBWW_CALC_MAXVAL;
@@ -551,3 +476,197 @@ int RGBWWColorUtils::parseColorCorrection(float val) {
 	if (val <= -30.0) val = -30.0;
 	return int(((val / 60) * (RGBWW_CALC_MAXVAL)) * -1);
 }
+
+
+
+/**************************************************************
+ *                     Hue Map
+ **************************************************************/
+
+RGBWWHueMaps::RGBWWHueMaps() {
+	_refs = 1;
+	int sector[7];
+	for (int i = 0; i <= 6; ++i) {
+		sector[i] = i*RGBWW_CALC_MAXVAL;
+	}
+	create(sector);
+	_maps[CUSTOM] = _maps[RAW];
+}
+
+
+RGBWWHueMaps* RGBWWHueMaps::getDefault() {
+	// holds one reference for the lifetime of the program
+	static RGBWWHueMaps maps;
+	return &maps;
+}
+
+
+void RGBWWHueMaps::release() {
+	if (--_refs == 0) {
+		delete this;
+	}
+}
+
+
+RGBWWHueMaps* RGBWWHueMaps::clone() const {
+	RGBWWHueMaps* maps = new RGBWWHueMaps(*this);
+	maps->_refs = 1;
+	return maps;
+}
+
+
+/*
+ * Creates the hue maps of the built in HSV models from the hue wheel
+ * sectors (see RGBWWColorConfig::createHueWheel)
+ */
+void RGBWWHueMaps::create(const int* sector) {
+	const int max = RGBWW_CALC_MAXVAL;
+	const int half = RGBWW_CALC_MAXVAL >> 1;
+
+	/*
+	 * RAW - https://en.wikipedia.org/wiki/HSL_and_HSV#From_HSV
+	 *
+	 * We have 6 sectors
+	 * We need 7 "borders" to incorporate the shift oft sectors
+	 *
+	 * Example: 8bit values
+	 * Sector 1 is from 0 - 255. We need border 0 as lower border, 255 as upper border.
+	 * Sector 6 is from 1275 - 1530. Lower border 1275, upper border 1530
+	 *
+	 * Apply a color correct for red with +10deg (value 25) results in
+	 * Sector 1 from 0 - 255 & 1505 - 1530
+	 * Sector 6 from 1275 - 1505
+	 *
+	 * Apply a color correct for red with -10deg (value 25) results in
+	 * Sector 1 from 25 - 255
+	 * Sector 6 from 1275 - 1530 && 0 - 25
+	 */
+	const RGBWWHueMapPoint raw[6] = {
+		{ sector[0], max, 0, 0 },		// red
+		{ sector[1], max, max, 0 },	// yellow
+		{ sector[2], 0, max, 0 },		// green
+		{ sector[3], 0, max, max },	// cyan
+		{ sector[4], 0, 0, max },		// blue
+		{ sector[5], max, 0, max }		// magenta
+	};
+	_maps[RAW].set(raw, 6);
+
+	/*
+	 * SPEKTRUM - keeps the max total color output equal
+	 * https://github.com/FastLED/FastLED/wiki/FastLED-HSV-Colors
+	 */
+	const RGBWWHueMapPoint spektrum[6] = {
+		{ sector[0], max, 0, 0 },
+		{ sector[1], half, half, 0 },
+		{ sector[2], 0, max, 0 },
+		{ sector[3], 0, half, half },
+		{ sector[4], 0, 0, max },
+		{ sector[5], half, 0, half }
+	};
+	_maps[SPEKTRUM].set(spektrum, 6);
+
+	/*
+	 * RAINBOW - based on the rainbow color table from FastLED
+	 * https://github.com/FastLED/FastLED/wiki/FastLED-HSV-Colors#color-map-rainbow-vs-spectrum
+	 * https://github.com/FastLED/FastLED/blob/master/colorutils.h
+	 *
+	 * The colors are placed on the hue wheel sectors, so the normal
+	 * hue range is transformed to the rainbow hue range
+	 * 0 - 60 to 0 - 90 (red - orange - yellow)
+	 * 60 - 120 to 90 - 135 (yellow - green)
+	 * 120 - 180 to 135 - 180 (green - aqua)
+	 * 180 - 240 to 180 - 225 (aqua - blue)
+	 * 240 - 300 to 225 - 270 (blue - purple)
+	 * 300 - 360 to 270 - 360 (purple - pink - red)
+	 */
+	const int third = RGBWW_CALC_MAXVAL / 3;
+	const int two_third = third * 2;
+	const RGBWWHueMapPoint rainbow[8] = {
+		{ sector[0], max, 0, 0 },						// red
+		{ (sector[0] + sector[1]) / 2, two_third, third, 0 },	// orange
+		{ sector[1], two_third, two_third, 0 },		// yellow
+		{ sector[2], 0, max, 0 },						// green
+		{ sector[3], 0, two_third, third },			// aqua
+		{ sector[4], 0, 0, max },						// blue
+		{ sector[5], third, 0, two_third },			// purple
+		{ (sector[5] + sector[6]) / 2, two_third, 0, third }	// pink
+	};
+	_maps[RAINBOW].set(rainbow, 8);
+}
+
+
+RGBWWHueMap::RGBWWHueMap() {
+	// empty map evaluates to black
+	_count = 0;
+	_offset = 0;
+	_segments[0].start = 0;
+	_segments[0].width = RGBWW_CALC_HUEWHEELMAX;
+	for (int i = 0; i < 3; i++) {
+		_segments[0].factor[i] = 0;
+		_segments[0].delta[i] = 0;
+	}
+	_segments[1].start = RGBWW_CALC_HUEWHEELMAX;
+	for (int i = 0; i < RGBWW_HUEMAP_INDEXSIZE; i++) {
+		_index[i] = 0;
+	}
+}
+
+
+bool RGBWWHueMap::set(const RGBWWHueMapPoint* points, int count) {
+	if (count < 2 || count > RGBWW_HUEMAP_MAXPOINTS) {
+		return false;
+	}
+
+	// positions relative to the first breakpoint, which need to be ascending
+	int offset = points[0].hue;
+	RGBWWColorUtils::circleHue(offset);
+	int pos[RGBWW_HUEMAP_MAXPOINTS + 1];
+	for (int i = 0; i < count; i++) {
+		pos[i] = points[i].hue - offset;
+		RGBWWColorUtils::circleHue(pos[i]);
+		if (i > 0 && pos[i] < pos[i-1]) {
+			return false;
+		}
+	}
+	pos[count] = RGBWW_CALC_HUEWHEELMAX;
+
+	_count = count;
+	_offset = offset;
+	for (int i = 0; i < count; i++) {
+		const RGBWWHueMapPoint& from = points[i];
+		const RGBWWHueMapPoint& to = points[(i + 1) % count];
+		Segment& seg = _segments[i];
+		seg.start = pos[i];
+		seg.width = pos[i + 1] - pos[i];
+		seg.factor[0] = from.r;
+		seg.factor[1] = from.g;
+		seg.factor[2] = from.b;
+		seg.delta[0] = to.r - from.r;
+		seg.delta[1] = to.g - from.g;
+		seg.delta[2] = to.b - from.b;
+	}
+	_segments[count].start = RGBWW_CALC_HUEWHEELMAX;
+
+	// first segment for each index entry
+	int segment = 0;
+	for (int i = 0; i < RGBWW_HUEMAP_INDEXSIZE; i++) {
+		int hue = ((i << RGBWW_HUEMAP_INDEXSHIFT) + RGBWW_HUEMAP_INDEXSCALE - 1) / RGBWW_HUEMAP_INDEXSCALE;
+		while (segment + 1 < count && hue >= _segments[segment + 1].start) {
+			segment++;
+		}
+		_index[i] = segment;
+	}
+	return true;
+}
+
+
+int RGBWWHueMap::get(RGBWWHueMapPoint* points) const {
+	for (int i = 0; i < _count; i++) {
+		points[i].hue = _segments[i].start + _offset;
+		RGBWWColorUtils::circleHue(points[i].hue);
+		points[i].r = _segments[i].factor[0];
+		points[i].g = _segments[i].factor[1];
+		points[i].b = _segments[i].factor[2];
+	}
+	return _count;
+}
@@ -21,7 +21,8 @@ enum RGBWW_HSVMODEL {
 	RAW = 0,
 	SPEKTRUM = 1,
 	RAINBOW = 2,
-	NUM_HSVMODELS = 3
+	CUSTOM = 3,
+	NUM_HSVMODELS = 4
 };
 
 enum RGBWW_CHANNELS {
@@ -34,6 +35,17 @@ enum RGBWW_CHANNELS {
 };
 
 
+// fixed point format of the calibration matrix (Q12 -> 4096 = 1.0)
+#define RGBWW_CALIBRATION_SHIFT 12
+#define RGBWW_CALIBRATION_ONE (1 << RGBWW_CALIBRATION_SHIFT)
+// accumulator for a row of 5 coefficients * calc values
+#if RGBWW_CALC_DEPTH > 13
+	#define RGBWW_CALIBRATION_ACC int64_t
+#else
+	#define RGBWW_CALIBRATION_ACC int32_t
+#endif
+
+
 //struct for RGBW + Kelvin
 struct RGBWCT {
 
@@ -126,6 +138,46 @@ struct ChannelOutput {
     }
 };
 
+/**
+ * Output values of a controller with an arbitrary number of channels
+ * (see RGBWWMultiLed) - ChannelOutput is the five channel RGBWW variant
+ *
+ * @tparam CHANNELS	number of channels
+ */
+template<int CHANNELS>
+struct RGBWWChannelValues {
+	int channel[CHANNELS];
+
+	RGBWWChannelValues() {}
+
+	RGBWWChannelValues(int value) {
+		for (int i = 0; i < CHANNELS; i++) {
+			channel[i] = value;
+		}
+	}
+
+	int& operator[] (int index) {
+		return channel[index];
+	}
+
+	const int& operator[] (int index) const {
+		return channel[index];
+	}
+
+	bool operator== (const RGBWWChannelValues& output) const {
+		for (int i = 0; i < CHANNELS; i++) {
+			if (channel[i] != output.channel[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool operator!= (const RGBWWChannelValues& output) const {
+		return !(*this == output);
+	}
+};
+
 // struct for HSV + Kelvin
 
 struct HSVCT {
@@ -169,6 +221,24 @@ struct HSVCT {
         this->ct = constrain(ct, 0, 10000);
     }
 
+    /**
+     * Construct from integer fixed point values
+     * Truncates like the float constructor without any floating
+     * point operation. Results where the float version lands just
+     * below an integer (i.e. 52.0 degrees) are one step higher - exact
+     *
+     * @param hue	hue in 1/10 degree [0, 3600]
+     * @param sat	saturation in 1/100 percent [0, 10000]
+     * @param val	value in 1/100 percent [0, 10000]
+     * @param ct	color temperature in kelvin [0, 10000]
+     */
+    static HSVCT fromFixed(int hue, int sat, int val, int ct = 0) {
+    	return HSVCT(int((long(constrain(hue, 0, 3600)) * RGBWW_CALC_HUEWHEELMAX) / 3600),
+    				 int((long(constrain(sat, 0, 10000)) * RGBWW_CALC_MAXVAL) / 10000),
+    				 int((long(constrain(val, 0, 10000)) * RGBWW_CALC_MAXVAL) / 10000),
+    				 int(constrain(ct, 0, 10000)));
+    }
+
     HSVCT(const HSVCT& hsvk)
     {
     	this->h = hsvk.h;
@@ -199,6 +269,24 @@ struct HSVCT {
 		ct = this->ct;
     }
 
+    /**
+     * Returns the color as integer fixed point values
+     *
+     * @param hue	hue in 1/10 degree
+     * @param sat	saturation in 1/100 percent
+     * @param val	value in 1/100 percent
+     */
+    void asFixed(int& hue, int& sat, int& val) {
+    	hue = int((long(h) * 3600) / RGBWW_CALC_HUEWHEELMAX);
+    	sat = int((long(s) * 10000) / RGBWW_CALC_MAXVAL);
+    	val = int((long(v) * 10000) / RGBWW_CALC_MAXVAL);
+    }
+
+    void asFixed(int& hue, int& sat, int& val, int& ct) {
+    	asFixed(hue, sat, val);
+    	ct = this->ct;
+    }
+
 
 
 };
@@ -217,6 +305,246 @@ struct COLOR {
 };
 
 
+// maximum number of breakpoints of a hue map
+#ifndef RGBWW_HUEMAP_MAXPOINTS
+	#define RGBWW_HUEMAP_MAXPOINTS 12
+#endif
+// number of entries of the segment lookup of a hue map
+#define RGBWW_HUEMAP_INDEXSIZE 32
+// fixed point scale for finding the index entry of a hue
+// (hue * scale stays below 2^29 for any calc depth)
+#define RGBWW_HUEMAP_INDEXSHIFT 24
+#define RGBWW_HUEMAP_INDEXSCALE ((RGBWW_HUEMAP_INDEXSIZE << RGBWW_HUEMAP_INDEXSHIFT) / RGBWW_CALC_HUEWHEELMAX)
+
+
+/**
+ * Breakpoint of a hue map
+ *
+ * Defines the factor of each color channel at full chroma
+ * for a position on the hue wheel
+ */
+struct RGBWWHueMapPoint {
+	int hue;	// position on the hue wheel [0, RGBWW_CALC_HUEWHEELMAX)
+	int r;		// factor red [0, RGBWW_CALC_MAXVAL]
+	int g;		// factor green [0, RGBWW_CALC_MAXVAL]
+	int b;		// factor blue [0, RGBWW_CALC_MAXVAL]
+};
+
+
+/**
+ * Piecewise linear mapping of the hue wheel to color channel factors
+ *
+ * The map is described by a list of breakpoints. Between two
+ * breakpoints the factors are interpolated linearly, the last
+ * breakpoint connects to the first one across the end of the hue wheel.
+ *
+ * The segment of a hue is found with a single table lookup
+ *
+ */
+class RGBWWHueMap
+{
+public:
+	RGBWWHueMap();
+
+	/**
+	 * Set the breakpoints of the map. Breakpoints need to be
+	 * ordered by hue, starting at any position of the hue wheel.
+	 * Two breakpoints at the same hue make a hard step
+	 *
+	 * @param points	array of breakpoints
+	 * @param count		number of breakpoints [2, RGBWW_HUEMAP_MAXPOINTS]
+	 * @retval true		map was set
+	 * @retval false	invalid breakpoints, map is unchanged
+	 */
+	bool set(const RGBWWHueMapPoint* points, int count);
+
+	/**
+	 * Copies the breakpoints of the map into the provided array
+	 *
+	 * @param points	array to hold RGBWW_HUEMAP_MAXPOINTS breakpoints
+	 * @return number of breakpoints
+	 */
+	int get(RGBWWHueMapPoint* points) const;
+
+	/**
+	 * Calculates the factors of the color channels for the hue
+	 * (channel = chroma * factor / RGBWW_CALC_MAXVAL)
+	 *
+	 * @param hue		hue [0, RGBWW_CALC_HUEWHEELMAX)
+	 * @param factor	array of 3 to hold the r, g, b factors
+	 */
+	void evaluate(int hue, int* factor) const;
+
+private:
+	struct Segment {
+		int	start;
+		int	width;
+		int	factor[3];
+		int	delta[3];
+	};
+
+	static inline int slope(int d, int fract, int width, int& delta, int& step) {
+		if (d == 0) return 0;
+		if (d == delta) return step;
+		if (d == -delta) return -step;
+		delta = d;
+		step = (RGBWW_CALC_WIDE(d) * fract) / width;
+		return step;
+	}
+
+	int		_count;
+	int		_offset;
+	// terminated by a segment starting at RGBWW_CALC_HUEWHEELMAX
+	Segment	_segments[RGBWW_HUEMAP_MAXPOINTS + 1];
+	uint8_t	_index[RGBWW_HUEMAP_INDEXSIZE];
+};
+
+
+inline void RGBWWHueMap::evaluate(int hue, int* factor) const {
+	hue -= _offset;
+	if (hue < 0) hue += RGBWW_CALC_HUEWHEELMAX;
+	if (hue >= RGBWW_CALC_HUEWHEELMAX) hue -= RGBWW_CALC_HUEWHEELMAX;
+
+	int segment = _index[(hue * RGBWW_HUEMAP_INDEXSCALE) >> RGBWW_HUEMAP_INDEXSHIFT];
+	while (hue >= _segments[segment + 1].start) {
+		segment++;
+	}
+
+	// interpolate - channels with the same slope share one division
+	const Segment& seg = _segments[segment];
+	int fract = hue - seg.start;
+	int delta = 0;
+	int step = 0;
+	factor[0] = seg.factor[0] + slope(seg.delta[0], fract, seg.width, delta, step);
+	factor[1] = seg.factor[1] + slope(seg.delta[1], fract, seg.width, delta, step);
+	factor[2] = seg.factor[2] + slope(seg.delta[2], fract, seg.width, delta, step);
+}
+
+
+/**
+ * Hue maps of the HSV models
+ *
+ * The maps are shared by all configurations with the same hue wheel
+ * correction and custom map (reference counted, copy on write like
+ * RGBWWColorConfig). Copying a configuration only copies the pointer.
+ */
+class RGBWWHueMaps {
+	friend class RGBWWColorConfig;
+	friend class RGBWWColorUtils;
+
+public:
+	/**
+	 * Returns the hue map used for a HSV model
+	 *
+	 * @param model		RGBWW_HSVMODEL
+	 * @return const RGBWWHueMap&
+	 */
+	const RGBWWHueMap& get(RGBWW_HSVMODEL model) const {
+		return _maps[(model < RGBWW_HSVMODEL::NUM_HSVMODELS) ? model : RGBWW_HSVMODEL::RAW];
+	}
+
+	/**
+	 * Number of configurations using the maps
+	 *
+	 * @return int
+	 */
+	int getUsers() const { return _refs; }
+
+private:
+	RGBWWHueMaps();
+	RGBWWHueMaps(const RGBWWHueMaps&) = default;
+	RGBWWHueMaps& operator=(const RGBWWHueMaps&) = delete;
+
+	static RGBWWHueMaps* getDefault();
+	void	acquire() { _refs++; }
+	void	release();
+	RGBWWHueMaps* clone() const;
+
+	void	create(const int* sector);
+
+	int			_refs;
+	RGBWWHueMap	_maps[RGBWW_HSVMODEL::NUM_HSVMODELS];
+};
+
+
+/**
+ * Last conversion of RGBWWColorUtils::HSVtoOutput
+ *
+ */
+struct RGBWWColorCache {
+	uint32_t		generation;
+	HSVCT			hsv;
+	RGBWCT			rgbw;
+	ChannelOutput	output;
+	int				factor[3];
+};
+
+
+/**
+ * Color configuration of RGBWWColorUtils
+ *
+ * Holds the settings and the tables derived from them. A configuration
+ * can be shared by several RGBWWColorUtils instances (reference counted).
+ * Shared configurations are never modified - changing a setting of one
+ * instance copies the configuration first (copy on write).
+ *
+ * All instances start with the default configuration
+ */
+class RGBWWColorConfig {
+	friend class RGBWWColorUtils;
+
+public:
+	/**
+	 * Returns the default configuration which is shared by
+	 * all instances that did not change any settings
+	 *
+	 * @return RGBWWColorConfig*
+	 */
+	static RGBWWColorConfig* getDefault();
+
+	/**
+	 * Number of RGBWWColorUtils instances using this configuration
+	 *
+	 * @return int
+	 */
+	int getUsers() const { return _refs; }
+
+private:
+	RGBWWColorConfig();
+	RGBWWColorConfig(const RGBWWColorConfig&) = default;
+	RGBWWColorConfig& operator=(const RGBWWColorConfig&) = delete;
+	~RGBWWColorConfig();
+
+	void	acquire() { _refs++; }
+	void	release();
+	RGBWWColorConfig* clone() const;
+
+	const RGBWWHueMap& hueMap(RGBWW_HSVMODEL model) const { return _hueMaps->get(model); }
+	RGBWWHueMaps* editHueMaps();
+
+	void	createHueWheel();
+	void	setBrightnessCorrection(int r, int g, int b, int ww, int cw);
+	void	resetCalibrationMatrix();
+	void	setWhiteTemperature(int WarmWhite, int ColdWhite);
+
+	int			_refs;
+	int         _BrightnessFactor[RGBWW_CHANNELS::NUM_CHANNELS];
+	int16_t     _CalibrationMatrix[RGBWW_CHANNELS::NUM_CHANNELS][RGBWW_CHANNELS::NUM_CHANNELS];
+	bool        _isCalibrated;
+	int         _HueWheelSector[7];
+	int         _HueWheelSectorWidth[6];
+	RGBWWHueMaps* _hueMaps;
+	int			_WarmWhiteKelvin;
+	int			_ColdWhiteKelvin;
+	int			_ColdWhiteMired;
+	// RGBWW_CALC_MAXVAL / (warm white - cold white mired) (16bit fixed point)
+	uint32_t	_MiredFactor;
+
+	RGBWW_COLORMODE       _colormode;
+	RGBWW_HSVMODEL         _hsvmodel;
+};
+
+
 /**
  * Class with functions for converting between different colorspaces
  * (HSVK, RGBWK), changing outputmodes (RGBWW_COLORMODE) and
@@ -228,7 +556,26 @@ class RGBWWColorUtils {
 
 public:
 	RGBWWColorUtils();
-	virtual 		~RGBWWColorUtils(){};
+	RGBWWColorUtils(const RGBWWColorUtils& other);
+	RGBWWColorUtils& operator=(const RGBWWColorUtils& other);
+	virtual 		~RGBWWColorUtils();
+
+
+	/**
+	 * Use the color configuration of another instance. Both instances
+	 * share the configuration until one of them changes a setting
+	 *
+	 * @param other	instance to share the configuration with
+	 */
+	void shareConfig(const RGBWWColorUtils& other);
+
+
+	/**
+	 * Returns the (read only) color configuration of the instance
+	 *
+	 * @return const RGBWWColorConfig*
+	 */
+	const RGBWWColorConfig* getConfig() const { return _config; }
 
 
 	/**
@@ -282,6 +629,28 @@ public:
 	void getWhiteTemperature(int& WarmWhite, int& ColdWhite);
 
 
+	/**
+	 * Converts a color temperature from kelvin to mired
+	 * Uses a lookup table, kelvin is clamped to
+	 * [RGBWW_KELVIN_MIN, RGBWW_KELVIN_MAX]
+	 *
+	 * @param kelvin	color temperature in kelvin
+	 * @return color temperature in mired (RGBWW_MIRED_SHIFT fractional bits)
+	 */
+	static inline int kelvinToMired(int kelvin) { return RGBWW_kelvin_to_mired[kelvin]; }
+
+
+	/**
+	 * Converts a color temperature from mired to kelvin
+	 * Uses a lookup table, mired is clamped to
+	 * [RGBWW_MIRED_MIN, RGBWW_MIRED_MAX]
+	 *
+	 * @param mired		color temperature in mired (RGBWW_MIRED_SHIFT fractional bits)
+	 * @return color temperature in kelvin
+	 */
+	static inline int miredToKelvin(int mired) { return RGBWW_mired_to_kelvin[mired]; }
+
+
 	/**
 	 * Correction for HSVtoRGB Normal Mode. Moves the boundaries
 	 * of each color further left/right. Assumes all variables are
@@ -341,6 +710,46 @@ public:
 	void getBrightnessCorrection(int& r, int& g, int& b, int& ww, int& cw);
 
 
+	/**
+	 * Set the calibration matrix for the led primaries.
+	 * Each output channel is calculated as the weighted sum of all
+	 * input channels:
+	 *
+	 *   out[i] = sum(matrix[i][j] * in[j]) / RGBWW_CALIBRATION_ONE
+	 *
+	 * Coefficients are fixed point values where RGBWW_CALIBRATION_ONE
+	 * (4096) equals 1.0 and are contained in [-32768, 32767].
+	 * Rows/columns are ordered as RGBWW_CHANNELS
+	 *
+	 * @param matrix	coefficients (row = output channel)
+	 */
+	void setCalibrationMatrix(const int matrix[RGBWW_CHANNELS::NUM_CHANNELS][RGBWW_CHANNELS::NUM_CHANNELS]);
+
+
+	/**
+	 * Copies the current calibration matrix into the provided array
+	 *
+	 * @param matrix
+	 */
+	void getCalibrationMatrix(int matrix[RGBWW_CHANNELS::NUM_CHANNELS][RGBWW_CHANNELS::NUM_CHANNELS]);
+
+
+	/**
+	 * Reset the calibration matrix to the identity matrix
+	 * (no calibration)
+	 *
+	 */
+	void resetCalibrationMatrix();
+
+
+	/**
+	 * Applies the calibration matrix to the channel values
+	 *
+	 * @param ChannelOutput& output
+	 */
+	void calibrate(ChannelOutput& output);
+
+
 	/**
 	 * Applies the white colortemperature
 	 *
@@ -351,6 +760,18 @@ public:
 	void whiteBalance(RGBWCT& rgbw, ChannelOutput& output);
 
 
+	/**
+	 * Applies the white colortemperature for a color mode
+	 * fixed at compile time. Ignores the mode set with setColorMode
+	 *
+	 * @tparam MODE		RGBWW_COLORMODE
+	 * @param RGBWK&	rgbw
+	 * @param ChannelOutput& output
+	 */
+	template<RGBWW_COLORMODE MODE>
+	void whiteBalance(const RGBWCT& rgbw, ChannelOutput& output);
+
+
 	/**
 	 * Corrects the values in the parsed array according to the set
 	 * brightness correction
@@ -360,6 +781,38 @@ public:
 	void correctBrightness(ChannelOutput& output);
 
 
+	/**
+	 * Convert HSVK values to channel output values
+	 * (HSVtoRGB + whiteBalance) with the current settings.
+	 *
+	 * The last conversion is cached: converting the same color again
+	 * returns the cached result, converting a color which only differs
+	 * in value rescales the cached chroma and white part instead of a
+	 * full conversion. Changing any setting invalidates the cache.
+	 *
+	 * @param hsvk		HSVK struct with values
+	 * @param output	ChannelOutput struct to hold result
+	 */
+	void HSVtoOutput(const HSVCT& hsvk, ChannelOutput& output);
+
+
+	/**
+	 * Copies the statistics of the conversion cache into the provided params
+	 *
+	 * @param hits		conversions returned from the cache
+	 * @param scaled	conversions where only the value was rescaled
+	 * @param misses	full conversions
+	 */
+	void getCacheStats(uint32_t& hits, uint32_t& scaled, uint32_t& misses);
+
+
+	/**
+	 * Reset the statistics of the conversion cache
+	 *
+	 */
+	void resetCacheStats();
+
+
 	/**
 	 * Convert HSVK Values to RGBK colorspace
 	 * Uses to conversion model set with setHSVmodel
@@ -380,6 +833,51 @@ public:
 	void HSVtoRGB(const HSVCT& hsvk, RGBWCT& rgbwk, RGBWW_HSVMODEL mode);
 
 
+	/**
+	 * Convert HSVK Values to RGBK colorspace with a conversion
+	 * model fixed at compile time. Ignores the model set with setHSVmodel
+	 *
+	 * @tparam MODEL	conversion model to be used (RGBWW_HSVMODEL)
+	 * @param hsvk		HSVK struct with values
+	 * @param rgbwk		RGBWK struct to hold result
+	 */
+	template<RGBWW_HSVMODEL MODEL>
+	void HSVtoRGB(const HSVCT& hsvk, RGBWCT& rgbwk);
+
+
+	/**
+	 * Set the hue map used by the CUSTOM HSV model
+	 * See RGBWWHueMap::set
+	 *
+	 * @param points	array of breakpoints
+	 * @param count		number of breakpoints
+	 * @retval true		map was set
+	 * @retval false	invalid breakpoints
+	 */
+	bool setHueMap(const RGBWWHueMapPoint* points, int count);
+
+
+	/**
+	 * Copies the breakpoints of the hue map used for
+	 * a HSV model into the provided array
+	 *
+	 * @param model		RGBWW_HSVMODEL
+	 * @param points	array to hold RGBWW_HUEMAP_MAXPOINTS breakpoints
+	 * @return number of breakpoints
+	 */
+	int getHueMap(RGBWW_HSVMODEL model, RGBWWHueMapPoint* points);
+
+
+	/**
+	 * Convert HSV values to RGB colorspace using a hue map
+	 *
+	 * @param hsvk		HSVK struct with values
+	 * @param rgbwk		RGBWK struct to hold result
+	 * @param map		hue map
+	 */
+	static void HSVtoRGBmap(const HSVCT& hsvk, RGBWCT& rgbwk, const RGBWWHueMap& map);
+
+
 	/**
 	 * Convert HSV values to RGB colorspace using the algorithm
 	 * from https://en.wikipedia.org/wiki/HSL_and_HSV#From_HSV
@@ -430,18 +928,108 @@ public:
 
 
 private:
-	int         _BrightnessFactor[RGBWW_CHANNELS::NUM_CHANNELS];
-	int         _HueWheelSector[7];
-	int         _HueWheelSectorWidth[6];
-	int			_WarmWhiteKelvin;
-	int			_ColdWhiteKelvin;
+	RGBWWColorConfig*	_config;
 
-	RGBWW_COLORMODE       _colormode;
-	RGBWW_HSVMODEL         _hsvmodel;
+	// incremented with every change of settings used by HSVtoOutput
+	uint32_t	_generation;
+	RGBWWColorCache	_cache;
+	uint32_t	_cacheHits;
+	uint32_t	_cacheScaled;
+	uint32_t	_cacheMisses;
 
+	RGBWWColorConfig*	editConfig();
 	static int 	parseColorCorrection(float val);
-	void    	createHueWheel();
+	static void	applyHueFactors(const HSVCT& hsvk, const int* factor, RGBWCT& rgbwk);
+
+	// chroma * factor / RGBWW_CALC_MAXVAL without division for pure colors
+	static inline int scaleChroma(int chroma, int factor) {
+		if (factor == 0) return 0;
+		if (factor == RGBWW_CALC_MAXVAL) return chroma;
+		return (RGBWW_CALC_WIDE(chroma) * factor) / RGBWW_CALC_MAXVAL;
+	}
 
 };
 
+
+/**************************************************************
+ *        compile time specialized conversion
+ *
+ * MODE/MODEL are template constants - the compiler resolves
+ * the switch statements and drops all unused branches
+ **************************************************************/
+
+template<RGBWW_COLORMODE MODE>
+inline void RGBWWColorUtils::whiteBalance(const RGBWCT& rgbw, ChannelOutput& output) {
+	/*
+	 * White balance will only be done on the w part
+	 * - a calibration is needed in order to be able to calculate the parts of
+	 * red/green/blue for calculating color temperatur
+	 *
+	 * color temperature will only be calculated for the "white part" in rgb
+	 * due to differences between led types, manufacturers and also different
+	 * (perceived) output levels with pwm and for different colors this is more
+	 * an estimation and should never be taken as a professional calculation
+	 *
+	 */
+	output.r = rgbw.r;
+	output.g = rgbw.g;
+	output.b = rgbw.b;
+	switch(MODE) {
+	case RGBWWCW:
+		if (_config->_WarmWhiteKelvin <= rgbw.ct && _config->_ColdWhiteKelvin >= rgbw.ct) {
+			// balance between CW and WW Leds - linear in mired, which
+			// follows the perceived difference of color temperatures
+			int mired = kelvinToMired(rgbw.ct) - _config->_ColdWhiteMired;
+			int wwfactor = (uint32_t(mired) * _config->_MiredFactor) >> 16;
+			output.warmwhite = (RGBWW_CALC_WIDE(rgbw.w) * wwfactor) /RGBWW_CALC_MAXVAL;
+			output.coldwhite = rgbw.w - output.warmwhite;
+		} else {
+			// if kelvin outside range - different calculation algorithm
+			// for now we asume a "neutral white" (0.5 CW, 0.5 WW)
+			output.warmwhite = rgbw.w/2;
+			output.coldwhite = rgbw.w/2;
+		}
+		break;
+	case RGBCW:
+		//TODO implement valid algorithm
+		output.warmwhite = 0;
+		output.coldwhite = rgbw.w;
+		break;
+
+	case RGBWW:
+		//TODO implement valid algorithm
+		output.warmwhite = rgbw.w;
+		output.coldwhite = 0;
+		break;
+
+	default:
+		//TODO implement valid algorithm
+		output.r += rgbw.w;
+		output.g += rgbw.w;
+		output.b += rgbw.w;
+		output.coldwhite = 0;
+		output.warmwhite = 0;
+		break;
+	}
+}
+
+
+template<RGBWW_HSVMODEL MODEL>
+inline void RGBWWColorUtils::HSVtoRGB(const HSVCT& hsvk, RGBWCT& rgbwk) {
+	switch(MODEL) {
+		case SPEKTRUM: {
+			HSVtoRGBspektrum(hsvk, rgbwk); break;
+		}
+		case RAINBOW: {
+			HSVtoRGBrainbow(hsvk, rgbwk); break;
+		}
+		case CUSTOM: {
+			HSVtoRGBmap(hsvk, rgbwk, _config->hueMap(CUSTOM)); break;
+		}
+		default: {
+			HSVtoRGBraw(hsvk, rgbwk); break;
+		}
+	}
+}
+
 #endif
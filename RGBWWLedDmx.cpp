@@ -0,0 +1,404 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ */
+
+#include "RGBWWLedDmx.h"
+#include <string.h>
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+
+/**************************************************************
+ *               packet layout
+ **************************************************************/
+
+// E1.31 (ANSI E1.31-2016)
+#define E131_ACN_ID				4		// "ASC-E1.17\0\0\0"
+#define E131_ROOT_VECTOR		18
+#define E131_FRAME_VECTOR		40
+#define E131_SEQUENCE			111
+#define E131_OPTIONS			112
+#define E131_UNIVERSE			113
+#define E131_DMP_VECTOR			117
+#define E131_PROPERTY_COUNT		123
+#define E131_START_CODE			125
+#define E131_DATA				126
+
+#define E131_VECTOR_ROOT_DATA	0x00000004
+#define E131_VECTOR_FRAME_DATA	0x00000002
+#define E131_VECTOR_DMP_SET		0x02
+#define E131_OPTION_PREVIEW		0x80
+#define E131_OPTION_TERMINATED	0x40
+
+// Art-Net 4
+#define ARTNET_OPCODE			8
+#define ARTNET_SEQUENCE			12
+#define ARTNET_SUBUNI			14
+#define ARTNET_NET				15
+#define ARTNET_LENGTH			16
+#define ARTNET_DATA				18
+
+#define ARTNET_OPDMX			0x5000
+
+static const uint8_t E131_ACN_PACKET_ID[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+static const uint8_t ARTNET_ID[8] = { 'A', 'r', 't', '-', 'N', 'e', 't', 0 };
+
+
+static inline uint16_t readUint16(const uint8_t* data) {
+	return (data[0] << 8) | data[1];
+}
+
+static inline uint32_t readUint32(const uint8_t* data) {
+	return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (data[2] << 8) | data[3];
+}
+
+// scale a dmx value to [0, maxval] - maxval is a compile time constant
+template<long MAXVAL>
+static inline int scaleDmx(uint8_t value) {
+	return (long(value) * MAXVAL + 127) / 255;
+}
+
+
+/**************************************************************
+ *               dmx receiver
+ **************************************************************/
+
+RGBWWDmxReceiver::RGBWWDmxReceiver(RGBWWLed* ctrl, uint16_t universe /* = 1 */, int address /* = 1 */) {
+	_ctrl = ctrl;
+	_raw = false;
+	setAddress(universe, address);
+	resetStats();
+}
+
+void RGBWWDmxReceiver::setAddress(uint16_t universe, int address) {
+	_universe = universe;
+	_address = constrain(address, 1, RGBWW_DMX_CHANNELS - RGBWW_CHANNELS::NUM_CHANNELS + 1);
+	_hasSequence = false;
+}
+
+void RGBWWDmxReceiver::setRaw(bool raw) {
+	_raw = raw;
+}
+
+bool RGBWWDmxReceiver::process(const uint8_t* data, int length) {
+	RGBWWDmxFrame frame;
+	_stats.packets++;
+	if (!parseE131(data, length, frame) && !parseArtNet(data, length, frame)) {
+		_stats.invalid++;
+		return false;
+	}
+	int first = _address - 1;
+	if (frame.universe != _universe || frame.data == NULL || frame.length < first + RGBWW_CHANNELS::NUM_CHANNELS) {
+		_stats.ignored++;
+		return false;
+	}
+	if (frame.sequence != 0 && !checkSequence(frame.sequence)) {
+		_stats.outoforder++;
+		return false;
+	}
+
+	const uint8_t* slots = frame.data + first;
+	if (_raw) {
+		int red = scaleDmx<RGBWW_PWMMAXVAL>(slots[RGBWW_CHANNELS::RED]);
+		int green = scaleDmx<RGBWW_PWMMAXVAL>(slots[RGBWW_CHANNELS::GREEN]);
+		int blue = scaleDmx<RGBWW_PWMMAXVAL>(slots[RGBWW_CHANNELS::BLUE]);
+		int ww = scaleDmx<RGBWW_PWMMAXVAL>(slots[RGBWW_CHANNELS::WW]);
+		int cw = scaleDmx<RGBWW_PWMMAXVAL>(slots[RGBWW_CHANNELS::CW]);
+		_ctrl->setOutputRaw(red, green, blue, ww, cw);
+	} else {
+		ChannelOutput output(scaleDmx<RGBWW_CALC_MAXVAL>(slots[RGBWW_CHANNELS::RED]),
+							 scaleDmx<RGBWW_CALC_MAXVAL>(slots[RGBWW_CHANNELS::GREEN]),
+							 scaleDmx<RGBWW_CALC_MAXVAL>(slots[RGBWW_CHANNELS::BLUE]),
+							 scaleDmx<RGBWW_CALC_MAXVAL>(slots[RGBWW_CHANNELS::WW]),
+							 scaleDmx<RGBWW_CALC_MAXVAL>(slots[RGBWW_CHANNELS::CW]));
+		_ctrl->setOutput(output);
+	}
+	_stats.frames++;
+	return true;
+}
+
+RGBWWDmxStats RGBWWDmxReceiver::getStats() {
+	return _stats;
+}
+
+void RGBWWDmxReceiver::resetStats() {
+	_stats.packets = 0;
+	_stats.frames = 0;
+	_stats.ignored = 0;
+	_stats.invalid = 0;
+	_stats.outoforder = 0;
+}
+
+bool RGBWWDmxReceiver::checkSequence(uint8_t sequence) {
+	// E1.31 6.7.2: drop packets up to 20 behind the last one
+	if (_hasSequence) {
+		int8_t diff = int8_t(sequence - _sequence);
+		if (diff <= 0 && diff > -20) {
+			return false;
+		}
+	}
+	_hasSequence = true;
+	_sequence = sequence;
+	return true;
+}
+
+bool RGBWWDmxReceiver::parseE131(const uint8_t* data, int length, RGBWWDmxFrame& frame) {
+	if (length < E131_DATA ||
+			memcmp(data + E131_ACN_ID, E131_ACN_PACKET_ID, sizeof(E131_ACN_PACKET_ID)) != 0 ||
+			readUint32(data + E131_ROOT_VECTOR) != E131_VECTOR_ROOT_DATA ||
+			readUint32(data + E131_FRAME_VECTOR) != E131_VECTOR_FRAME_DATA ||
+			data[E131_DMP_VECTOR] != E131_VECTOR_DMP_SET) {
+		return false;
+	}
+	frame.protocol = RGBWW_DMX_PROTOCOL::RGBWW_DMX_E131;
+	frame.universe = readUint16(data + E131_UNIVERSE);
+	frame.sequence = data[E131_SEQUENCE];
+	frame.data = NULL;
+	frame.length = 0;
+	// only dmx data (start code 0) which is not preview data
+	if (data[E131_START_CODE] == 0 && !(data[E131_OPTIONS] & (E131_OPTION_PREVIEW | E131_OPTION_TERMINATED))) {
+		int count = readUint16(data + E131_PROPERTY_COUNT) - 1;
+		frame.data = data + E131_DATA;
+		frame.length = constrain(count, 0, length - E131_DATA);
+	}
+	return true;
+}
+
+bool RGBWWDmxReceiver::parseArtNet(const uint8_t* data, int length, RGBWWDmxFrame& frame) {
+	if (length < ARTNET_DATA ||
+			memcmp(data, ARTNET_ID, sizeof(ARTNET_ID)) != 0 ||
+			(data[ARTNET_OPCODE] | (data[ARTNET_OPCODE + 1] << 8)) != ARTNET_OPDMX) {
+		return false;
+	}
+	frame.protocol = RGBWW_DMX_PROTOCOL::RGBWW_DMX_ARTNET;
+	frame.universe = ((data[ARTNET_NET] & 0x7F) << 8) | data[ARTNET_SUBUNI];
+	frame.sequence = data[ARTNET_SEQUENCE];
+	frame.data = data + ARTNET_DATA;
+	frame.length = constrain(int(readUint16(data + ARTNET_LENGTH)), 0, length - ARTNET_DATA);
+	return true;
+}
+
+
+
+/**************************************************************
+ *               E1.31 sender
+ **************************************************************/
+
+#define E131_SOURCE_NAME		44
+#define E131_PRIORITY			108
+#define E131_CID				22
+
+static void writeUint16(uint8_t* data, uint16_t value) {
+	data[0] = value >> 8;
+	data[1] = value & 0xFF;
+}
+
+// flags (0x7) and length of a pdu starting at offset
+static void writePduLength(uint8_t* data, int offset) {
+	writeUint16(data + offset, 0x7000 | (RGBWW_E131_PACKETSIZE - offset));
+}
+
+
+RGBWWE131Output::RGBWWE131Output(RGBWWE131Sender* sender, uint16_t universe, int address) {
+	_sender = sender;
+	_slots = sender->getSlots(universe);
+	_universe = universe;
+	address = constrain(address, 1, RGBWW_DMX_CHANNELS - RGBWW_CHANNELS::NUM_CHANNELS + 1);
+	if (_slots != NULL) {
+		_slots += address - 1;
+	}
+}
+
+void RGBWWE131Output::setOutput(int red, int green, int blue, int warmwhite, int coldwhite) {
+	if (_slots == NULL) {
+		return;
+	}
+	uint8_t slots[RGBWW_CHANNELS::NUM_CHANNELS] = {
+		uint8_t((long(red) * 255 + RGBWW_PWMMAXVAL / 2) / RGBWW_PWMMAXVAL),
+		uint8_t((long(green) * 255 + RGBWW_PWMMAXVAL / 2) / RGBWW_PWMMAXVAL),
+		uint8_t((long(blue) * 255 + RGBWW_PWMMAXVAL / 2) / RGBWW_PWMMAXVAL),
+		uint8_t((long(warmwhite) * 255 + RGBWW_PWMMAXVAL / 2) / RGBWW_PWMMAXVAL),
+		uint8_t((long(coldwhite) * 255 + RGBWW_PWMMAXVAL / 2) / RGBWW_PWMMAXVAL)
+	};
+	if (memcmp(_slots, slots, sizeof(slots)) != 0) {
+		memcpy(_slots, slots, sizeof(slots));
+		_sender->setChanged(_universe);
+	}
+}
+
+
+RGBWWE131Sender::RGBWWE131Sender(RGBWWDmxTransport* transport, uint16_t firstUniverse /* = 1 */, int universes /* = 1 */) {
+	_transport = transport;
+	_firstUniverse = firstUniverse;
+	_universes = (universes > 0) ? universes : 1;
+	_buffer = new uint8_t[_universes * RGBWW_E131_PACKETSIZE];
+	_changed = new bool[_universes];
+	_lastSent = new unsigned long[_universes];
+	_packets = 0;
+	for (int i = 0; i < _universes; i++) {
+		initPacket(i);
+	}
+	setSource("RGBWWLed");
+}
+
+RGBWWE131Sender::~RGBWWE131Sender() {
+	delete[] _buffer;
+	delete[] _changed;
+	delete[] _lastSent;
+}
+
+void RGBWWE131Sender::initPacket(int index) {
+	uint8_t* data = packet(index);
+	memset(data, 0, RGBWW_E131_PACKETSIZE);
+	// root layer
+	writeUint16(data, 0x0010);
+	memcpy(data + E131_ACN_ID, E131_ACN_PACKET_ID, sizeof(E131_ACN_PACKET_ID));
+	writePduLength(data, 16);
+	data[E131_ROOT_VECTOR + 3] = E131_VECTOR_ROOT_DATA;
+	// framing layer
+	writePduLength(data, 38);
+	data[E131_FRAME_VECTOR + 3] = E131_VECTOR_FRAME_DATA;
+	data[E131_PRIORITY] = 100;
+	writeUint16(data + E131_UNIVERSE, _firstUniverse + index);
+	// dmp layer
+	writePduLength(data, 115);
+	data[E131_DMP_VECTOR] = E131_VECTOR_DMP_SET;
+	data[E131_DMP_VECTOR + 1] = 0xA1;	// address and data type
+	writeUint16(data + E131_DMP_VECTOR + 4, 0x0001);	// address increment
+	writeUint16(data + E131_PROPERTY_COUNT, RGBWW_DMX_CHANNELS + 1);
+
+	_changed[index] = true;
+	_lastSent[index] = 0;
+}
+
+void RGBWWE131Sender::setSource(const char* name, const uint8_t* cid /* = NULL */) {
+	for (int i = 0; i < _universes; i++) {
+		uint8_t* data = packet(i);
+		memset(data + E131_SOURCE_NAME, 0, 64);
+		strncpy((char*)data + E131_SOURCE_NAME, name, 63);
+		if (cid != NULL) {
+			memcpy(data + E131_CID, cid, 16);
+		}
+	}
+}
+
+void RGBWWE131Sender::setPriority(uint8_t priority) {
+	for (int i = 0; i < _universes; i++) {
+		packet(i)[E131_PRIORITY] = priority;
+	}
+}
+
+uint8_t* RGBWWE131Sender::getSlots(uint16_t universe) {
+	int index = universe - _firstUniverse;
+	if (index < 0 || index >= _universes) {
+		return NULL;
+	}
+	return packet(index) + E131_DATA;
+}
+
+void RGBWWE131Sender::setChanged(uint16_t universe) {
+	int index = universe - _firstUniverse;
+	if (index < 0 || index >= _universes) {
+		return;
+	}
+	_changed[index] = true;
+}
+
+int RGBWWE131Sender::send() {
+	RGBWWDmxPacket batch[RGBWW_DMX_MAXBATCH];
+	int index[RGBWW_DMX_MAXBATCH];
+	int count = 0;
+	int sent = 0;
+	unsigned long now = millis();
+	for (int i = 0; i < _universes; i++) {
+		if (!_changed[i] && now - _lastSent[i] < RGBWW_E131_KEEPALIVE) {
+			continue;
+		}
+		uint8_t* data = packet(i);
+		data[E131_SEQUENCE]++;
+		batch[count].universe = _firstUniverse + i;
+		batch[count].data = data;
+		batch[count].length = RGBWW_E131_PACKETSIZE;
+		index[count] = i;
+		count++;
+		if (count == RGBWW_DMX_MAXBATCH) {
+			sent += sendBatch(batch, index, count, now);
+			count = 0;
+		}
+	}
+	if (count > 0) {
+		sent += sendBatch(batch, index, count, now);
+	}
+	_packets += sent;
+	return sent;
+}
+
+int RGBWWE131Sender::sendBatch(const RGBWWDmxPacket* batch, const int* index, int count, unsigned long now) {
+	int sent = _transport->send(batch, count);
+	sent = constrain(sent, 0, count);
+	// the transport sends in order - universes of the packets
+	// which were not sent stay changed and are sent with the next frame
+	for (int i = 0; i < sent; i++) {
+		_changed[index[i]] = false;
+		_lastSent[index[i]] = now;
+	}
+	return sent;
+}
+
+uint32_t RGBWWE131Sender::getPackets() {
+	return _packets;
+}
+
+
+
+#ifdef __linux__
+/**************************************************************
+ *               linux udp transport
+ **************************************************************/
+
+RGBWWLinuxUdp::RGBWWLinuxUdp(const char* host /* = NULL */, uint16_t port /* = RGBWW_E131_PORT */) {
+	_socket = socket(AF_INET, SOCK_DGRAM, 0);
+	_host = (host != NULL) ? inet_addr(host) : 0;
+	_port = htons(port);
+}
+
+RGBWWLinuxUdp::~RGBWWLinuxUdp() {
+	if (_socket >= 0) {
+		close(_socket);
+	}
+}
+
+int RGBWWLinuxUdp::send(const RGBWWDmxPacket* packets, int count) {
+	if (_socket < 0) {
+		return 0;
+	}
+	struct mmsghdr msgs[RGBWW_DMX_MAXBATCH];
+	struct iovec iov[RGBWW_DMX_MAXBATCH];
+	struct sockaddr_in addr[RGBWW_DMX_MAXBATCH];
+	count = (count < RGBWW_DMX_MAXBATCH) ? count : RGBWW_DMX_MAXBATCH;
+	for (int i = 0; i < count; i++) {
+		memset(&addr[i], 0, sizeof(addr[i]));
+		addr[i].sin_family = AF_INET;
+		addr[i].sin_port = _port;
+		// multicast 239.255.<universe hi>.<universe lo>
+		addr[i].sin_addr.s_addr = (_host != 0) ? _host : htonl(0xEFFF0000 | packets[i].universe);
+		iov[i].iov_base = (void*)packets[i].data;
+		iov[i].iov_len = packets[i].length;
+		memset(&msgs[i], 0, sizeof(msgs[i]));
+		msgs[i].msg_hdr.msg_name = &addr[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(addr[i]);
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+	int sent = sendmmsg(_socket, msgs, count, 0);
+	return (sent > 0) ? sent : 0;
+}
+#endif
@@ -0,0 +1,345 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ */
+
+#ifndef RGBWWLedDmx_h
+#define RGBWWLedDmx_h
+#include "RGBWWLed.h"
+
+
+#define RGBWW_DMX_CHANNELS		512
+#define RGBWW_E131_PORT			5568
+#define RGBWW_ARTNET_PORT		6454
+
+
+enum RGBWW_DMX_PROTOCOL {
+	RGBWW_DMX_E131 = 0,
+	RGBWW_DMX_ARTNET = 1
+};
+
+
+/**
+ * DMX data of a received packet
+ *
+ * data points into the packet buffer - the payload is not copied
+ *
+ */
+struct RGBWWDmxFrame {
+	RGBWW_DMX_PROTOCOL	protocol;
+	uint16_t		universe;
+	uint8_t			sequence;	// 0 = sequence not used
+	const uint8_t*	data;		// dmx slots, data[0] = channel 1
+	int				length;		// number of dmx slots
+};
+
+
+/**
+ * Statistics of the dmx receiver
+ *
+ */
+struct RGBWWDmxStats {
+	uint32_t	packets;	// packets passed to process()
+	uint32_t	frames;		// frames applied to the controller
+	uint32_t	ignored;	// other universe, preview data or too short
+	uint32_t	invalid;	// no E1.31/Art-Net dmx packet
+	uint32_t	outoforder;	// dropped because of the sequence number
+};
+
+
+/**
+ * Receiver for E1.31 (sACN) and Art-Net dmx packets
+ *
+ * Packets are received by the application (i.e. with an udp connection
+ * listening on RGBWW_E131_PORT/RGBWW_ARTNET_PORT) and passed to process().
+ * The dmx slots starting at the configured address are mapped to the
+ * red, green, blue, warm white and cold white channel of the controller
+ * and written to the output directly.
+ *
+ * Animations of the controller should be stopped while receiving,
+ * otherwise they overwrite the output of the receiver.
+ *
+ */
+class RGBWWDmxReceiver
+{
+public:
+	/**
+	 * @param RGBWWLed*	ctrl		controller to write the output to
+	 * @param uint16_t	universe
+	 * @param int		address		dmx address of the first channel (1 - 508)
+	 */
+	RGBWWDmxReceiver(RGBWWLed* ctrl, uint16_t universe = 1, int address = 1);
+
+	/**
+	 * Set the universe and dmx address of the first channel
+	 *
+	 * @param uint16_t	universe
+	 * @param int		address		(1 - 508)
+	 */
+	void	setAddress(uint16_t universe, int address);
+
+	/**
+	 * Write the dmx values as pwm duties (setOutputRaw) instead of
+	 * passing them through the color pipeline (setOutput) with
+	 * calibration, brightness correction and dim curve
+	 *
+	 * The 8bit dmx values are scaled to whole pwm duties, temporal
+	 * dithering gains no resolution in raw mode (see RGBWWLed::setOutputRaw)
+	 *
+	 * @param bool	raw
+	 */
+	void	setRaw(bool raw);
+
+	/**
+	 * Parse a packet and write the channels to the controller
+	 *
+	 * @param uint8_t*	data	udp payload
+	 * @param int		length
+	 * @retval true		output was updated
+	 * @retval false	packet was ignored
+	 */
+	bool	process(const uint8_t* data, int length);
+
+	/**
+	 * Returns the statistics of the receiver
+	 *
+	 * @return RGBWWDmxStats
+	 */
+	RGBWWDmxStats getStats();
+
+	/**
+	 * Reset the statistics of the receiver
+	 *
+	 */
+	void	resetStats();
+
+	/**
+	 * Parse an E1.31 data packet
+	 *
+	 * @param uint8_t*			data	udp payload
+	 * @param int				length
+	 * @param RGBWWDmxFrame&	frame	holds the result
+	 * @retval true		packet is an E1.31 data packet
+	 * @retval false	invalid packet
+	 */
+	static bool parseE131(const uint8_t* data, int length, RGBWWDmxFrame& frame);
+
+	/**
+	 * Parse an Art-Net ArtDmx packet
+	 *
+	 * @param uint8_t*			data	udp payload
+	 * @param int				length
+	 * @param RGBWWDmxFrame&	frame	holds the result
+	 * @retval true		packet is an ArtDmx packet
+	 * @retval false	invalid packet
+	 */
+	static bool parseArtNet(const uint8_t* data, int length, RGBWWDmxFrame& frame);
+
+private:
+	RGBWWLed*	_ctrl;
+	uint16_t	_universe;
+	int			_address;
+	bool		_raw;
+	bool		_hasSequence;
+	uint8_t		_sequence;
+	RGBWWDmxStats _stats;
+
+	bool	checkSequence(uint8_t sequence);
+};
+
+
+
+/*
+ * unchanged universes are sent again after RGBWW_E131_KEEPALIVE ms
+ * so receivers do not time out (E1.31 6.6.2)
+ */
+#ifndef RGBWW_E131_KEEPALIVE
+	#define RGBWW_E131_KEEPALIVE 1000
+#endif
+
+// maximum number of packets passed to the transport in one call
+#ifndef RGBWW_DMX_MAXBATCH
+	#define RGBWW_DMX_MAXBATCH 32
+#endif
+
+#define RGBWW_E131_PACKETSIZE	(126 + RGBWW_DMX_CHANNELS)
+
+
+/**
+ * Packet to be sent by a RGBWWDmxTransport
+ *
+ */
+struct RGBWWDmxPacket {
+	uint16_t		universe;
+	const uint8_t*	data;
+	int				length;
+};
+
+
+/**
+ * Transport sending dmx packets (i.e. udp)
+ *
+ */
+class RGBWWDmxTransport
+{
+public:
+	virtual ~RGBWWDmxTransport() {};
+
+	/**
+	 * Send a batch of packets
+	 *
+	 * Packets are sent in order, if not all packets could be sent
+	 * the first ones (return value) are the ones which were sent
+	 *
+	 * @param RGBWWDmxPacket*	packets
+	 * @param int				count	(at most RGBWW_DMX_MAXBATCH)
+	 * @return int	number of packets sent
+	 */
+	virtual int send(const RGBWWDmxPacket* packets, int count) = 0;
+};
+
+
+#ifdef __linux__
+/**
+ * Udp transport for linux hosts
+ *
+ * Batches are sent with a single sendmmsg() call. Packets go to the
+ * given host or, without host, to the E1.31 multicast address of
+ * their universe (239.255.hi.lo)
+ *
+ */
+class RGBWWLinuxUdp: public RGBWWDmxTransport
+{
+public:
+	/**
+	 * @param char*		host	ipv4 address of the receiver, NULL for multicast
+	 * @param uint16_t	port
+	 */
+	RGBWWLinuxUdp(const char* host = NULL, uint16_t port = RGBWW_E131_PORT);
+	virtual ~RGBWWLinuxUdp();
+
+	int send(const RGBWWDmxPacket* packets, int count);
+
+private:
+	int			_socket;
+	uint32_t	_host;
+	uint16_t	_port;
+};
+#endif
+
+
+class RGBWWE131Sender;
+
+/**
+ * Output backend writing the channels of a controller to five
+ * slots of an E1.31 universe
+ *
+ * The universe is sent by the RGBWWE131Sender which collects the
+ * outputs of all controllers
+ *
+ */
+class RGBWWE131Output: public RGBWWOutput
+{
+public:
+	/**
+	 * @param RGBWWE131Sender*	sender
+	 * @param uint16_t			universe	one of the universes of the sender
+	 * @param int				address		dmx address of the first channel (1 - 508)
+	 */
+	RGBWWE131Output(RGBWWE131Sender* sender, uint16_t universe, int address);
+
+	void	setOutput(int red, int green, int blue, int warmwhite, int coldwhite);
+
+private:
+	RGBWWE131Sender*	_sender;
+	uint16_t	_universe;
+	uint8_t*	_slots;
+};
+
+
+/**
+ * Sends the channel frames of many controllers as E1.31 universes
+ *
+ * The packets of all universes are allocated once and reused,
+ * only the changed slots and the sequence numbers are updated.
+ * send() passes all changed universes to the transport in batches.
+ *
+ */
+class RGBWWE131Sender
+{
+public:
+	/**
+	 * @param RGBWWDmxTransport*	transport
+	 * @param uint16_t		firstUniverse
+	 * @param int			universes		number of consecutive universes
+	 */
+	RGBWWE131Sender(RGBWWDmxTransport* transport, uint16_t firstUniverse = 1, int universes = 1);
+	~RGBWWE131Sender();
+
+	/**
+	 * Set the source name and component identifier of the packets
+	 *
+	 * @param char*		name	up to 63 characters
+	 * @param uint8_t*	cid		16 byte uuid, NULL keeps the current cid
+	 */
+	void	setSource(const char* name, const uint8_t* cid = NULL);
+
+	/**
+	 * Set the priority of the packets
+	 *
+	 * @param uint8_t	priority	(0 - 200, default 100)
+	 */
+	void	setPriority(uint8_t priority);
+
+	/**
+	 * Send all changed universes and the ones due for keep alive
+	 * Call once per frame after updating the controllers
+	 *
+	 * Universes the transport could not send stay changed
+	 * and are sent again with the next call
+	 *
+	 * @return int	number of packets sent
+	 */
+	int		send();
+
+	/**
+	 * Returns the dmx slots of a universe (slots[0] = channel 1)
+	 *
+	 * @param uint16_t	universe
+	 * @return uint8_t*	NULL if the universe is not handled by the sender
+	 */
+	uint8_t* getSlots(uint16_t universe);
+
+	/**
+	 * Mark a universe as changed
+	 * Universes not handled by the sender are ignored
+	 *
+	 * @param uint16_t	universe
+	 */
+	void	setChanged(uint16_t universe);
+
+	/**
+	 * Number of packets sent
+	 *
+	 * @return uint32_t
+	 */
+	uint32_t getPackets();
+
+private:
+	RGBWWDmxTransport*	_transport;
+	uint16_t	_firstUniverse;
+	int			_universes;
+	uint8_t*	_buffer;
+	bool*		_changed;
+	unsigned long* _lastSent;
+	uint32_t	_packets;
+
+	uint8_t* packet(int index) { return _buffer + index * RGBWW_E131_PACKETSIZE; }
+	void	initPacket(int index);
+	int		sendBatch(const RGBWWDmxPacket* batch, const int* index, int count, unsigned long now);
+};
+
+#endif //RGBWWLedDmx_h
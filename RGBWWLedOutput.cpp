@@ -33,6 +33,8 @@ PWMOutput::PWMOutput(uint8_t redPin, uint8_t greenPin, uint8_t bluePin, uint8_t
 	_maxduty = (period * 1000) / 45;
 	pwm_set_period(period);
 	pwm_start();
+	_dirty = false;
+	resetStats();
 }
 
 void PWMOutput::setFrequency(int freq){
@@ -47,96 +49,118 @@ int	PWMOutput::getFrequency() {
 	return _freq;
 }
 
+/*
+ * pwm_start() recalculates the complete phase table of the sdk pwm.
+ * The duties are kept in a shadow and the pwm is only started
+ * when a duty actually changed
+ */
 void PWMOutput::setRed(int duty, bool update /* = true */) {
-	if (duty != getRed()) {
-        pwm_set_duty(duty, RGBWW_CHANNELS::RED);
-        _duty[RGBWW_CHANNELS::RED] = pwm_get_duty(RGBWW_CHANNELS::RED);
-
-		if(update) {
-			pwm_start();
-		}
-	}
+	setChannel(RGBWW_CHANNELS::RED, duty, update);
 }
 
 int	PWMOutput::getRed(){
-	return pwm_get_duty(RGBWW_CHANNELS::RED);
+	return _duty[RGBWW_CHANNELS::RED];
 }
 
 void PWMOutput::setGreen(int duty, bool update /* = true */) {
-    if (duty != getGreen()) {
-        pwm_set_duty(duty, RGBWW_CHANNELS::GREEN);
-        _duty[RGBWW_CHANNELS::GREEN] = pwm_get_duty(RGBWW_CHANNELS::GREEN);
-		if(update) {
-			pwm_start();
-		}
-	}
+	setChannel(RGBWW_CHANNELS::GREEN, duty, update);
 }
 
 int	PWMOutput::getGreen() {
-	return pwm_get_duty(RGBWW_CHANNELS::GREEN);
+	return _duty[RGBWW_CHANNELS::GREEN];
 }
 
 void PWMOutput::setBlue(int duty, bool update /* = true */) {
-    if (duty != getBlue()) {
-        pwm_set_duty(duty, RGBWW_CHANNELS::BLUE);
-        _duty[RGBWW_CHANNELS::BLUE] = pwm_get_duty(RGBWW_CHANNELS::BLUE);
-		if(update) {
-			pwm_start();
-		}
-	}
+	setChannel(RGBWW_CHANNELS::BLUE, duty, update);
 }
 
 int PWMOutput::getBlue(){
-	return pwm_get_duty(RGBWW_CHANNELS::BLUE);
+	return _duty[RGBWW_CHANNELS::BLUE];
 }
 
 void PWMOutput::setWarmWhite(int duty, bool update /* = true */) {
-	if (duty != getWarmWhite()) {
-        pwm_set_duty(duty, RGBWW_CHANNELS::WW);
-        _duty[RGBWW_CHANNELS::WW] = pwm_get_duty(RGBWW_CHANNELS::WW);
-		if(update) {
-			pwm_start();
-		}
-	}
+	setChannel(RGBWW_CHANNELS::WW, duty, update);
 }
 
 int	PWMOutput::getWarmWhite() {
-	return pwm_get_duty(RGBWW_CHANNELS::WW);
+	return _duty[RGBWW_CHANNELS::WW];
 }
 
 void PWMOutput::setColdWhite(int duty, bool update /* = true */) {
-    if (duty != getColdWhite()) {
-        pwm_set_duty(duty, RGBWW_CHANNELS::CW);
-        _duty[RGBWW_CHANNELS::CW] = pwm_get_duty(RGBWW_CHANNELS::CW);
-		if(update) {
-			pwm_start();
-		}
-	}
+	setChannel(RGBWW_CHANNELS::CW, duty, update);
 }
+
 int	PWMOutput::getColdWhite(){
-	return pwm_get_duty(RGBWW_CHANNELS::CW);
+	return _duty[RGBWW_CHANNELS::CW];
 }
 
 void PWMOutput::setOutput(int red, int green, int blue, int warmwhite, int coldwhite){
-	debugRGBW("R:%i | G:%i | B:%i | WW:%i | CW:%i", red, green, blue, warmwhite, coldwhite);
-	setRed(red, false);
-	setGreen(green, false);
-	setBlue(blue, false);
-	setWarmWhite(warmwhite, false);
-	setColdWhite(coldwhite, false);
+	traceRGBW(TRACE_PWM, red, green, blue, warmwhite, coldwhite);
+	setChannel(RGBWW_CHANNELS::RED, red, false);
+	setChannel(RGBWW_CHANNELS::GREEN, green, false);
+	setChannel(RGBWW_CHANNELS::BLUE, blue, false);
+	setChannel(RGBWW_CHANNELS::WW, warmwhite, false);
+	setChannel(RGBWW_CHANNELS::CW, coldwhite, false);
 	//only call pwm start at the end of all changes
 	//might cause delay/missed changes otherwise
-	pwm_start();
+	update();
 
 }
 
+void PWMOutput::setDuties(const int* duty, bool update /* = true */) {
+	for (int i = 0; i < RGBWW_CHANNELS::NUM_CHANNELS; i++) {
+		setChannel(i, duty[i], false);
+	}
+	if (update) {
+		this->update();
+	}
+}
 
-#else
+void PWMOutput::update() {
+	if (_dirty) {
+		// the sdk applies the new duties of all channels together
+		// at the start of the next pwm period
+		pwm_start();
+		_stats.updates++;
+		_dirty = false;
+	}
+}
+
+RGBWWPWMStats PWMOutput::getStats() {
+	return _stats;
+}
+
+void PWMOutput::resetStats() {
+	_stats.writes = 0;
+	_stats.skipped = 0;
+	_stats.updates = 0;
+}
+
+void PWMOutput::setChannel(int channel, int duty, bool update) {
+	if (duty != _duty[channel]) {
+		pwm_set_duty(duty, channel);
+		_duty[channel] = duty;
+		_dirty = true;
+		_stats.writes++;
+	} else {
+		_stats.skipped++;
+	}
+	if (update) {
+		this->update();
+	}
+}
+
+
+#elif defined(RGBWW_USE_ARDUINO_PWM)
 
 /*
  * If not using pwm implementation from espressif esp sdk
  * we fallback to the standard arduino pwm implementation
  *
+ * analogWrite reconfigures the timer waveform on every call,
+ * so the last written duties are cached and only channels
+ * with a changed duty are written
+ *
  */
 PWMOutput::PWMOutput(uint8_t redPin, uint8_t greenPin, uint8_t bluePin, uint8_t wwPin, uint8_t cwPin, uint16_t freq /* = 200 */) {
 
@@ -151,12 +175,20 @@ PWMOutput::PWMOutput(uint8_t redPin, uint8_t greenPin, uint8_t bluePin, uint8_t
 	pinMode(wwPin, OUTPUT);
 	pinMode(cwPin, OUTPUT);
 	setFrequency(freq);
-	_maxduty = RGBWW_ARDUINO_MAXDUTY;
 
+	// write the initial state of all channels once
+	for (int i = 0; i < RGBWW_CHANNELS::NUM_CHANNELS; i++) {
+		_duty[i] = 0;
+	}
+	_dirty = (1 << RGBWW_CHANNELS::NUM_CHANNELS) - 1;
+	resetStats();
+	update();
 }
 
 void PWMOutput::setFrequency(int freq){
 	_freq = freq;
+	// parseDuty scales to RGBWW_ARDUINO_MAXDUTY - keep the core in the same range
+	analogWriteRange(RGBWW_ARDUINO_MAXDUTY);
 	analogWriteFreq(freq);
 }
 
@@ -165,8 +197,7 @@ int	PWMOutput::getFrequency() {
 }
 
 void PWMOutput::setRed(int value, bool update /* = true */) {
-	_duty[RGBWW_CHANNELS::RED] = parseDuty(value);
-	analogWrite(_pins[RGBWW_CHANNELS::RED], value);
+	setChannel(RGBWW_CHANNELS::RED, value, update);
 }
 
 int PWMOutput::getRed() {
@@ -175,8 +206,7 @@ int PWMOutput::getRed() {
 
 
 void PWMOutput::setGreen(int value, bool update /* = true */) {
-	_duty[RGBWW_CHANNELS::GREEN] = parseDuty(value);
-	analogWrite(_pins[RGBWW_CHANNELS::GREEN], value);
+	setChannel(RGBWW_CHANNELS::GREEN, value, update);
 }
 
 int PWMOutput::getGreen() {
@@ -184,8 +214,7 @@ int PWMOutput::getGreen() {
 }
 
 void PWMOutput::setBlue(int value, bool update /* = true */) {
-	_duty[RGBWW_CHANNELS::BLUE] = parseDuty(value);
-	analogWrite(_pins[RGBWW_CHANNELS::BLUE], value);
+	setChannel(RGBWW_CHANNELS::BLUE, value, update);
 }
 
 int	PWMOutput::getBlue() {
@@ -194,8 +223,7 @@ int	PWMOutput::getBlue() {
 
 
 void PWMOutput::setWarmWhite(int value, bool update /* = true */) {
-	_duty[RGBWW_CHANNELS::WW] = parseDuty(value);
-	analogWrite(_pins[RGBWW_CHANNELS::WW], value);
+	setChannel(RGBWW_CHANNELS::WW, value, update);
 }
 
 int PWMOutput::getWarmWhite() {
@@ -203,8 +231,7 @@ int PWMOutput::getWarmWhite() {
 }
 
 void PWMOutput::setColdWhite(int value, bool update /* = true */) {
-	_duty[RGBWW_CHANNELS::CW] = parseDuty(value);
-	analogWrite(_pins[RGBWW_CHANNELS::CW], value);
+	setChannel(RGBWW_CHANNELS::CW, value, update);
 }
 
 int	PWMOutput::getColdWhite() {
@@ -212,14 +239,342 @@ int	PWMOutput::getColdWhite() {
 }
 
 void PWMOutput::setOutput(int red, int green, int blue, int warmwhite, int coldwhite){
-	setRed(red);
-	setGreen(green);
-	setBlue(blue);
-	setWarmWhite(warmwhite);
-	setColdWhite(coldwhite);
+	setChannel(RGBWW_CHANNELS::RED, red, false);
+	setChannel(RGBWW_CHANNELS::GREEN, green, false);
+	setChannel(RGBWW_CHANNELS::BLUE, blue, false);
+	setChannel(RGBWW_CHANNELS::WW, warmwhite, false);
+	setChannel(RGBWW_CHANNELS::CW, coldwhite, false);
+	//write all changed channels at once
+	update();
+}
+
+void PWMOutput::setDuties(const int* duty, bool update /* = true */) {
+	for (int i = 0; i < RGBWW_CHANNELS::NUM_CHANNELS; i++) {
+		setChannel(i, duty[i], false);
+	}
+	if (update) {
+		this->update();
+	}
+}
+
+void PWMOutput::update() {
+	if (_dirty == 0) {
+		return;
+	}
+	for (int i = 0; i < RGBWW_CHANNELS::NUM_CHANNELS; i++) {
+		if (_dirty & (1 << i)) {
+			analogWrite(_pins[i], _duty[i]);
+			_stats.writes++;
+		}
+	}
+	_dirty = 0;
+	_stats.updates++;
+}
+
+RGBWWPWMStats PWMOutput::getStats() {
+	return _stats;
+}
+
+void PWMOutput::resetStats() {
+	_stats.writes = 0;
+	_stats.skipped = 0;
+	_stats.updates = 0;
+}
+
+void PWMOutput::setChannel(int channel, int value, bool update) {
+	int duty = parseDuty(value);
+	if (duty != _duty[channel]) {
+		_duty[channel] = duty;
+		_dirty |= (1 << channel);
+	} else if (!(_dirty & (1 << channel))) {
+		_stats.skipped++;
+	}
+	if (update) {
+		this->update();
+	}
 }
 
 int PWMOutput::parseDuty(int duty) {
-	return (duty * _maxduty) / RGBWW_CALC_WIDTH;
+#if RGBWW_ARDUINO_MAXDUTY == RGBWW_PWMMAXVAL
+	return duty;
+#else
+	return (long(duty) * RGBWW_ARDUINO_MAXDUTY) / RGBWW_PWMMAXVAL;
+#endif
 }
 #endif //RGBWW_USE_ESP_HWPWM
+
+
+
+/**************************************************************
+ *               recording output
+ **************************************************************/
+
+RGBWWRecordingOutput::RGBWWRecordingOutput(int size) {
+	_size = (size > 0) ? size : 1;
+	_frames = new RGBWWOutputFrame[_size];
+	clear();
+}
+
+RGBWWRecordingOutput::~RGBWWRecordingOutput() {
+	delete[] _frames;
+}
+
+void RGBWWRecordingOutput::setOutput(int red, int green, int blue, int warmwhite, int coldwhite) {
+	int back = _front + _count;
+	if (back >= _size) back -= _size;
+	if (_count == _size) {
+		// buffer full - drop the oldest frame
+		_front = (_front + 1 < _size) ? _front + 1 : 0;
+		_overflows++;
+	} else {
+		_count++;
+	}
+	RGBWWOutputFrame& frame = _frames[back];
+	frame.time = micros();
+	frame.duty[RGBWW_CHANNELS::RED] = red;
+	frame.duty[RGBWW_CHANNELS::GREEN] = green;
+	frame.duty[RGBWW_CHANNELS::BLUE] = blue;
+	frame.duty[RGBWW_CHANNELS::WW] = warmwhite;
+	frame.duty[RGBWW_CHANNELS::CW] = coldwhite;
+	_total++;
+}
+
+int RGBWWRecordingOutput::getCount() {
+	return _count;
+}
+
+bool RGBWWRecordingOutput::getFrame(int index, RGBWWOutputFrame& frame) {
+	if (index < 0 || index >= _count) {
+		return false;
+	}
+	int pos = _front + index;
+	if (pos >= _size) pos -= _size;
+	frame = _frames[pos];
+	return true;
+}
+
+bool RGBWWRecordingOutput::pop(RGBWWOutputFrame& frame) {
+	if (_count == 0) {
+		return false;
+	}
+	frame = _frames[_front];
+	_front = (_front + 1 < _size) ? _front + 1 : 0;
+	_count--;
+	return true;
+}
+
+void RGBWWRecordingOutput::clear() {
+	_count = 0;
+	_front = 0;
+	_total = 0;
+	_overflows = 0;
+}
+
+uint32_t RGBWWRecordingOutput::getFrames() {
+	return _total;
+}
+
+uint32_t RGBWWRecordingOutput::getOverflows() {
+	return _overflows;
+}
+
+
+
+/**************************************************************
+ *               PCA9685 i2c pwm expander
+ **************************************************************/
+
+// registers
+#define PCA9685_MODE1		0x00
+#define PCA9685_MODE2		0x01
+#define PCA9685_LED0_ON_L	0x06
+#define PCA9685_PRESCALE	0xFE
+
+// MODE1 bits
+#define PCA9685_RESTART		0x80
+#define PCA9685_AI			0x20
+#define PCA9685_SLEEP		0x10
+// MODE2 bits
+#define PCA9685_OUTDRV		0x04
+
+// bit 4 of LEDn_ON_H / LEDn_OFF_H switches the channel fully on/off
+#define PCA9685_FULL		0x10
+
+#define PCA9685_OSCILLATOR	25000000L
+
+
+RGBWWPCA9685Output::RGBWWPCA9685Output(RGBWWI2CBus* bus, uint8_t address /* = 0x40 */) {
+	_bus = bus;
+	_address = address;
+	for (int i = 0; i < RGBWW_PCA9685_CHANNELS; i++) {
+		_duty[i] = 0;
+	}
+	_dirty = 0;
+	resetStats();
+}
+
+bool RGBWWPCA9685Output::begin(int freq /* = 200 */) {
+	long prescale = (PCA9685_OSCILLATOR + 2048L * freq) / (4096L * freq) - 1;
+	prescale = constrain(prescale, 3, 255);
+
+	// prescaler can only be set while sleeping
+	if (!writeRegister(PCA9685_MODE1, PCA9685_SLEEP | PCA9685_AI) ||
+			!writeRegister(PCA9685_PRESCALE, prescale) ||
+			!writeRegister(PCA9685_MODE2, PCA9685_OUTDRV) ||
+			!writeRegister(PCA9685_MODE1, PCA9685_AI)) {
+		return false;
+	}
+	// the oscillator needs 500us to start up
+	delayMicroseconds(500);
+	if (!writeRegister(PCA9685_MODE1, PCA9685_RESTART | PCA9685_AI)) {
+		return false;
+	}
+
+	for (int i = 0; i < RGBWW_PCA9685_CHANNELS; i++) {
+		_duty[i] = 0;
+	}
+	_dirty = (1 << RGBWW_PCA9685_CHANNELS) - 1;
+	return update();
+}
+
+void RGBWWPCA9685Output::setDuties(const int* duty) {
+	for (int i = 0; i < RGBWW_PCA9685_CHANNELS; i++) {
+		setDuty(i, duty[i], false);
+	}
+	update();
+}
+
+void RGBWWPCA9685Output::setDuty(int channel, int duty, bool update /* = true */) {
+	int value = parseDuty(duty);
+	if (value != _duty[channel]) {
+		_duty[channel] = value;
+		_dirty |= (1 << channel);
+	} else if (!(_dirty & (1 << channel))) {
+		_stats.skipped++;
+	}
+	if (update) {
+		this->update();
+	}
+}
+
+int RGBWWPCA9685Output::getDuty(int channel) {
+	return _duty[channel];
+}
+
+bool RGBWWPCA9685Output::update() {
+	const int maxchannels = (RGBWW_I2C_MAXWRITE - 1) / 4;
+	int channel = 0;
+	while (_dirty != 0) {
+		// find the next range of changed channels, bridging small gaps
+		while (!(_dirty & (1 << channel))) {
+			channel++;
+		}
+		int first = channel;
+		int last = channel;
+		for (int i = channel + 1; i < RGBWW_PCA9685_CHANNELS && i - first < maxchannels; i++) {
+			if (_dirty & (1 << i)) {
+				last = i;
+			} else if (i - last > RGBWW_PCA9685_MAXGAP) {
+				break;
+			}
+		}
+		if (!writeChannels(first, last)) {
+			return false;
+		}
+		channel = last + 1;
+	}
+	return true;
+}
+
+RGBWWPWMStats RGBWWPCA9685Output::getStats() {
+	return _stats;
+}
+
+void RGBWWPCA9685Output::resetStats() {
+	_stats.writes = 0;
+	_stats.skipped = 0;
+	_stats.updates = 0;
+}
+
+bool RGBWWPCA9685Output::writeRegister(uint8_t reg, uint8_t value) {
+	uint8_t data[2] = { reg, value };
+	return _bus->write(_address, data, 2);
+}
+
+bool RGBWWPCA9685Output::writeChannels(int first, int last) {
+	uint8_t data[RGBWW_I2C_MAXWRITE];
+	int length = 0;
+	data[length++] = PCA9685_LED0_ON_L + 4 * first;
+	for (int i = first; i <= last; i++) {
+		int duty = _duty[i];
+		// all channels switch on at 0 - only the off time varies
+		data[length++] = 0;
+		data[length++] = (duty == RGBWW_PCA9685_MAXVAL) ? PCA9685_FULL : 0;
+		data[length++] = duty & 0xFF;
+		data[length++] = (duty == 0) ? PCA9685_FULL : (duty >> 8);
+	}
+	_stats.updates++;
+	if (!_bus->write(_address, data, length)) {
+		return false;
+	}
+	_stats.writes += last - first + 1;
+	_dirty &= ~(((1 << (last - first + 1)) - 1) << first);
+	return true;
+}
+
+int RGBWWPCA9685Output::parseDuty(int duty) {
+#if RGBWW_PWMMAXVAL == RGBWW_PCA9685_MAXVAL
+	return duty;
+#else
+	return (long(duty) * RGBWW_PCA9685_MAXVAL + RGBWW_PWMMAXVAL / 2) / RGBWW_PWMMAXVAL;
+#endif
+}
+
+
+RGBWWPCA9685LedOutput::RGBWWPCA9685LedOutput(RGBWWPCA9685Output* chip, int red, int green, int blue, int warmwhite, int coldwhite) {
+	_chip = chip;
+	_channels[RGBWW_CHANNELS::RED] = red;
+	_channels[RGBWW_CHANNELS::GREEN] = green;
+	_channels[RGBWW_CHANNELS::BLUE] = blue;
+	_channels[RGBWW_CHANNELS::WW] = warmwhite;
+	_channels[RGBWW_CHANNELS::CW] = coldwhite;
+}
+
+void RGBWWPCA9685LedOutput::setOutput(int red, int green, int blue, int warmwhite, int coldwhite) {
+	_chip->setDuty(_channels[RGBWW_CHANNELS::RED], red, false);
+	_chip->setDuty(_channels[RGBWW_CHANNELS::GREEN], green, false);
+	_chip->setDuty(_channels[RGBWW_CHANNELS::BLUE], blue, false);
+	_chip->setDuty(_channels[RGBWW_CHANNELS::WW], warmwhite, false);
+	_chip->setDuty(_channels[RGBWW_CHANNELS::CW], coldwhite, false);
+	_chip->update();
+}
+
+
+
+/**************************************************************
+ *               temporal dithering
+ **************************************************************/
+
+void RGBWWDither::setOutput(int red, int green, int blue, int warmwhite, int coldwhite) {
+	const int duty[RGBWW_CHANNELS::NUM_CHANNELS] = { red, green, blue, warmwhite, coldwhite };
+	setDuties(duty);
+}
+
+
+
+/**************************************************************
+ *               power limiter
+ **************************************************************/
+
+void RGBWWPowerLimiter::setChannelPower(int r, int g, int b, int ww, int cw) {
+	const int power[RGBWW_CHANNELS::NUM_CHANNELS] = { r, g, b, ww, cw };
+	setChannelPower(power);
+}
+
+void RGBWWPowerLimiter::getChannelPower(int& r, int& g, int& b, int& ww, int& cw) {
+	r = _power[RGBWW_CHANNELS::RED];
+	g = _power[RGBWW_CHANNELS::GREEN];
+	b = _power[RGBWW_CHANNELS::BLUE];
+	ww = _power[RGBWW_CHANNELS::WW];
+	cw = _power[RGBWW_CHANNELS::CW];
+}
@@ -10,6 +10,62 @@
 #include "RGBWWLed.h"
 
 
+/**
+ * Output backend of the controller
+ *
+ * Receives the duties of all channels once per frame.
+ * Duties are in the range of [0, RGBWW_PWMMAXVAL]
+ *
+ */
+class RGBWWOutput
+{
+public:
+	virtual ~RGBWWOutput() {};
+
+	/**
+	 * Set the duties of all channels
+	 *
+	 * @param int	red
+	 * @param int	green
+	 * @param int	blue
+	 * @param int	warmwhite
+	 * @param int	coldwhite
+	 */
+	virtual void setOutput(int red, int green, int blue, int warmwhite, int coldwhite) = 0;
+};
+
+
+/**
+ * Output backend of a controller with CHANNELS channels (see RGBWWMultiLed)
+ *
+ * @tparam CHANNELS	number of channels
+ */
+template<int CHANNELS>
+class RGBWWMultiOutput
+{
+public:
+	virtual ~RGBWWMultiOutput() {};
+
+	/**
+	 * Set the duties of all channels
+	 *
+	 * @param int[]	duty	array of CHANNELS duties in the range of [0, RGBWW_PWMMAXVAL]
+	 */
+	virtual void setDuties(const int* duty) = 0;
+};
+
+
+/**
+ * Statistics of the pwm output
+ *
+ */
+struct RGBWWPWMStats {
+	uint32_t	writes;		// channel duties written to the pwm
+	uint32_t	skipped;	// channel writes saved because the duty did not change
+	uint32_t	updates;	// updates of the pwm with at least one changed channel
+};
+
+
 #ifdef RGBWW_USE_ESP_HWPWM
 
 /*
@@ -24,7 +80,7 @@ extern "C" {
 
 
 
-class PWMOutput
+class PWMOutput: public RGBWWOutput
 {
 
 public:
@@ -44,17 +100,46 @@ public:
 	int		getColdWhite();
 	void	setOutput(int red, int green, int blue, int warmwhite, int coldwhite);
 
+	/**
+	 * Set the duties of all channels and start the pwm once
+	 *
+	 * @param int[]	duty	array of RGBWW_CHANNELS::NUM_CHANNELS duties
+	 * @param bool	update	start the pwm with the new duties
+	 */
+	void	setDuties(const int* duty, bool update = true);
+
+	/**
+	 * Start the pwm with all channels changed since the last update
+	 *
+	 */
+	void	update();
+
+	/**
+	 * Returns the write statistics of the output
+	 *
+	 * @return RGBWWPWMStats
+	 */
+	RGBWWPWMStats getStats();
+
+	/**
+	 * Reset the write statistics of the output
+	 *
+	 */
+	void	resetStats();
+
 
 private:
-	int		parseDuty(int duty);
+	void	setChannel(int channel, int duty, bool update);
 	int		_freq;
 	int		_duty[RGBWW_CHANNELS::NUM_CHANNELS];
 	int		_maxduty;
+	bool	_dirty;
+	RGBWWPWMStats _stats;
 
 
 };
 
-#else
+#elif defined(RGBWW_USE_ARDUINO_PWM)
 
 /*
  * If not using pwm implementation from espressif esp sdk
@@ -62,7 +147,15 @@ private:
  *
  */
 
-class PWMOutput
+/*
+ * duty range of analogWrite (see analogWriteRange)
+ * duties in [0, RGBWW_PWMMAXVAL] are scaled to [0, RGBWW_ARDUINO_MAXDUTY]
+ */
+#ifndef RGBWW_ARDUINO_MAXDUTY
+	#define RGBWW_ARDUINO_MAXDUTY RGBWW_PWMMAXVAL
+#endif
+
+class PWMOutput: public RGBWWOutput
 {
 
 	public:
@@ -82,15 +175,554 @@ class PWMOutput
 		int		getColdWhite();
 		void	setOutput(int red, int green, int blue, int warmwhite, int coldwhite);
 
+		/**
+		 * Set the duties of all channels and write the changed ones
+		 *
+		 * @param int[]	duty	array of RGBWW_CHANNELS::NUM_CHANNELS duties
+		 * @param bool	update	write the changed channels to the pins
+		 */
+		void	setDuties(const int* duty, bool update = true);
+
+		/**
+		 * Write all channels changed since the last update to the pins
+		 *
+		 */
+		void	update();
+
+		/**
+		 * Returns the write statistics of the output
+		 *
+		 * @return RGBWWPWMStats
+		 */
+		RGBWWPWMStats getStats();
+
+		/**
+		 * Reset the write statistics of the output
+		 *
+		 */
+		void	resetStats();
+
 
 	private:
 		int		_freq;
 		int		_pins[RGBWW_CHANNELS::NUM_CHANNELS];
 		int		_duty[RGBWW_CHANNELS::NUM_CHANNELS];
-		int		_maxduty;
+		uint8_t	_dirty;
+		RGBWWPWMStats _stats;
+		void	setChannel(int channel, int value, bool update);
 		int		parseDuty(int duty);
 
 };
 #endif //RGBWW_USE_ESP_HWPWM
 
+
+/**
+ * Frame recorded by RGBWWRecordingOutput
+ *
+ */
+struct RGBWWOutputFrame {
+	uint32_t	time;	// micros() when the frame was set
+	uint16_t	duty[RGBWW_CHANNELS::NUM_CHANNELS];
+};
+
+
+/**
+ * Output backend recording the frames instead of driving pins
+ *
+ * Frames are stored with a timestamp in a ring buffer which is
+ * allocated once. When the buffer is full the oldest frame
+ * is overwritten.
+ *
+ * Allows running the controller without hardware (i.e. on a host
+ * for testing and benchmarking)
+ *
+ */
+class RGBWWRecordingOutput: public RGBWWOutput
+{
+public:
+	/**
+	 * @param int	size	number of frames the buffer holds
+	 */
+	RGBWWRecordingOutput(int size);
+	virtual ~RGBWWRecordingOutput();
+
+	void	setOutput(int red, int green, int blue, int warmwhite, int coldwhite);
+
+	/**
+	 * Number of frames in the buffer
+	 *
+	 * @return int
+	 */
+	int		getCount();
+
+	/**
+	 * Returns a frame from the buffer without removing it
+	 *
+	 * @param int	index	0 = oldest frame, getCount() - 1 = newest frame
+	 * @param RGBWWOutputFrame&	frame	holds the frame
+	 * @retval true		frame was copied
+	 * @retval false	index is not in the buffer
+	 */
+	bool	getFrame(int index, RGBWWOutputFrame& frame);
+
+	/**
+	 * Removes the oldest frame from the buffer
+	 *
+	 * @param RGBWWOutputFrame&	frame	holds the removed frame
+	 * @retval true		frame was removed
+	 * @retval false	buffer is empty
+	 */
+	bool	pop(RGBWWOutputFrame& frame);
+
+	/**
+	 * Removes all frames from the buffer and resets the counters
+	 *
+	 */
+	void	clear();
+
+	/**
+	 * Total number of frames set since the last clear
+	 *
+	 * @return uint32_t
+	 */
+	uint32_t getFrames();
+
+	/**
+	 * Number of frames overwritten before being read
+	 *
+	 * @return uint32_t
+	 */
+	uint32_t getOverflows();
+
+private:
+	RGBWWOutputFrame*	_frames;
+	int			_size;
+	int			_count;
+	int			_front;
+	uint32_t	_total;
+	uint32_t	_overflows;
+};
+
+
+/**
+ * I2C bus used by RGBWWPCA9685Output
+ *
+ * Implement write() for the I2C driver of the platform (i.e. Wire)
+ *
+ */
+class RGBWWI2CBus
+{
+public:
+	virtual ~RGBWWI2CBus() {};
+
+	/**
+	 * Write data to a device in one transaction (start, address, data, stop)
+	 *
+	 * @param uint8_t	address	7bit address of the device
+	 * @param uint8_t*	data
+	 * @param int		length	number of bytes (at most RGBWW_I2C_MAXWRITE)
+	 * @retval true		device acknowledged all bytes
+	 * @retval false	write failed
+	 */
+	virtual bool write(uint8_t address, const uint8_t* data, int length) = 0;
+};
+
+/*
+ * maximum number of bytes in one i2c write (including the register)
+ * the arduino Wire buffer holds 32 bytes
+ */
+#ifndef RGBWW_I2C_MAXWRITE
+	#define RGBWW_I2C_MAXWRITE 32
+#endif
+
+/*
+ * number of unchanged channels between changed ones
+ * which are rewritten instead of starting a new transaction
+ */
+#ifndef RGBWW_PCA9685_MAXGAP
+	#define RGBWW_PCA9685_MAXGAP 1
+#endif
+
+#define RGBWW_PCA9685_CHANNELS		16
+#define RGBWW_PCA9685_MAXVAL		4095
+
+static_assert(RGBWW_I2C_MAXWRITE >= 5, "RGBWW_I2C_MAXWRITE can not hold one channel");
+
+
+/**
+ * Output backend for a PCA9685 16 channel 12bit i2c pwm expander
+ *
+ * Keeps a shadow of the channel registers and only writes the
+ * channels which changed. Consecutive changed channels are written in
+ * one transaction using the register auto increment of the chip.
+ *
+ */
+class RGBWWPCA9685Output: public RGBWWMultiOutput<RGBWW_PCA9685_CHANNELS>
+{
+public:
+	/**
+	 * @param RGBWWI2CBus*	bus		bus the chip is connected to
+	 * @param uint8_t		address	7bit address of the chip
+	 */
+	RGBWWPCA9685Output(RGBWWI2CBus* bus, uint8_t address = 0x40);
+
+	/**
+	 * Initialize the chip and switch all channels off
+	 *
+	 * @param int	freq	pwm frequency (24 - 1526 Hz)
+	 * @retval true		chip initialized
+	 * @retval false	bus error
+	 */
+	bool	begin(int freq = 200);
+
+	/**
+	 * Set the duties of all channels and write the changed ones
+	 *
+	 * @param int[]	duty	array of 16 duties in the range of [0, RGBWW_PWMMAXVAL]
+	 */
+	void	setDuties(const int* duty);
+
+	/**
+	 * Set the duty of one channel
+	 *
+	 * @param int	channel
+	 * @param int	duty	[0, RGBWW_PWMMAXVAL]
+	 * @param bool	update	write the changed channels to the chip
+	 */
+	void	setDuty(int channel, int duty, bool update = true);
+
+	/**
+	 * Returns the duty of a channel in the range of [0, RGBWW_PCA9685_MAXVAL]
+	 *
+	 * @param int	channel
+	 * @return int
+	 */
+	int		getDuty(int channel);
+
+	/**
+	 * Write all changed channels to the chip
+	 *
+	 * Channels stay pending if the bus reports an error
+	 *
+	 * @retval true		all channels written
+	 * @retval false	bus error
+	 */
+	bool	update();
+
+	/**
+	 * Returns the write statistics of the output
+	 * (updates counts the i2c transactions)
+	 *
+	 * @return RGBWWPWMStats
+	 */
+	RGBWWPWMStats getStats();
+
+	/**
+	 * Reset the write statistics of the output
+	 *
+	 */
+	void	resetStats();
+
+private:
+	RGBWWI2CBus*	_bus;
+	uint8_t		_address;
+	uint16_t	_duty[RGBWW_PCA9685_CHANNELS];
+	uint16_t	_dirty;
+	RGBWWPWMStats _stats;
+
+	bool	writeRegister(uint8_t reg, uint8_t value);
+	bool	writeChannels(int first, int last);
+	static int parseDuty(int duty);
+};
+
+
+/**
+ * Output backend driving the five channels of RGBWWLed with
+ * five channels of a PCA9685 (RGBWWPCA9685Output only implements
+ * RGBWWMultiOutput<16> for RGBWWMultiLed)
+ *
+ * Several controllers can share one chip, i.e. three RGBWW lamps
+ * on channels 0-4, 5-9 and 10-14.
+ *
+ */
+class RGBWWPCA9685LedOutput: public RGBWWOutput
+{
+public:
+	/**
+	 * The chip is not deleted by the output
+	 *
+	 * @param RGBWWPCA9685Output*	chip
+	 * @param int	red			channel of the chip
+	 * @param int	green		channel of the chip
+	 * @param int	blue		channel of the chip
+	 * @param int	warmwhite	channel of the chip
+	 * @param int	coldwhite	channel of the chip
+	 */
+	RGBWWPCA9685LedOutput(RGBWWPCA9685Output* chip, int red, int green, int blue, int warmwhite, int coldwhite);
+
+	void	setOutput(int red, int green, int blue, int warmwhite, int coldwhite);
+
+private:
+	RGBWWPCA9685Output*	_chip;
+	int		_channels[RGBWW_CHANNELS::NUM_CHANNELS];
+};
+
+
+#define RGBWW_DITHER_MASK ((1 << RGBWW_DITHER_BITS) - 1)
+
+/**
+ * Temporal (sigma-delta) dithering of the output of CHANNELS channels
+ *
+ * Takes duties with RGBWW_DITHER_BITS fractional bits and spreads
+ * the fraction over consecutive frames by carrying the
+ * remainder of each channel in an error accumulator
+ *
+ * @tparam CHANNELS	number of channels
+ */
+template<int CHANNELS>
+class RGBWWChannelDither
+{
+public:
+	RGBWWChannelDither() {
+		for (int i = 0; i < CHANNELS; i++) {
+			_target[i] = 0;
+			_error[i] = 0;
+		}
+		_active = false;
+	}
+
+	/**
+	 * Set the duties to be dithered
+	 *
+	 * @param int[]	duty	array of CHANNELS duties in the range of [0, RGBWW_DIM_CURVE_MAXVAL]
+	 */
+	void	setDuties(const int* duty) {
+		int fraction = 0;
+		for (int i = 0; i < CHANNELS; i++) {
+			_target[i] = duty[i];
+			fraction |= duty[i];
+		}
+		_active = (fraction & RGBWW_DITHER_MASK) != 0;
+	}
+
+	/**
+	 * Calculate the pwm duties for the next frame
+	 *
+	 * @param int[]	duty	array of CHANNELS to hold result
+	 */
+	void	nextFrame(int* duty) {
+		for (int i = 0; i < CHANNELS; i++) {
+			int sum = _target[i] + _error[i];
+			duty[i] = sum >> RGBWW_DITHER_BITS;
+			_error[i] = sum & RGBWW_DITHER_MASK;
+		}
+	}
+
+	/**
+	 * Check if the current output needs dithering
+	 *
+	 * @retval true		the output is dithered (needs further frames)
+	 * @retval false	the output is constant
+	 */
+	bool	isActive() {
+		return _active;
+	}
+
+private:
+	int		_target[CHANNELS];
+	int		_error[CHANNELS];
+	bool	_active;
+};
+
+
+/**
+ * Temporal dithering of the five RGBWW channels
+ *
+ */
+class RGBWWDither : public RGBWWChannelDither<RGBWW_CHANNELS::NUM_CHANNELS>
+{
+public:
+	/**
+	 * Set the duties to be dithered
+	 * Values are in the range of [0, RGBWW_DIM_CURVE_MAXVAL]
+	 */
+	void	setOutput(int red, int green, int blue, int warmwhite, int coldwhite);
+};
+
+
+/**
+ * Statistics of the power limiter
+ *
+ * Scales are given in 1/1000 of the requested output
+ * (1000 = not limited)
+ */
+struct RGBWWPowerStats {
+	uint32_t	frames;
+	uint32_t	limited;
+	uint16_t	lastscale;
+	uint16_t	minscale;
+};
+
+
+/**
+ * Limits the total power of CHANNELS channels to a configurable budget.
+ *
+ * The load of a frame is calculated as the sum of each channel duty
+ * multiplied by the power of that channel at full duty. If the load
+ * exceeds the budget all channels are scaled down by the same factor,
+ * keeping the color of the output.
+ *
+ * @tparam CHANNELS	number of channels
+ */
+template<int CHANNELS>
+class RGBWWChannelPowerLimiter
+{
+public:
+	RGBWWChannelPowerLimiter() {
+		_budget = 0;
+		for (int i = 0; i < CHANNELS; i++) {
+			_power[i] = 1;
+		}
+		resetStats();
+	}
+
+	/**
+	 * Set the maximum power of all channels combined
+	 *
+	 * @param int	budget	power budget (i.e. in mW), 0 disables the limiter
+	 */
+	void	setBudget(int budget) {
+		_budget = (budget > 0) ? budget : 0;
+	}
+
+	/**
+	 * Returns the current power budget
+	 *
+	 * @return int
+	 */
+	int		getBudget() {
+		return _budget;
+	}
+
+	/**
+	 * Set the power of each channel at full duty
+	 * (same unit as the budget, i.e. mW)
+	 *
+	 * @param int[]	power	array of CHANNELS
+	 */
+	void	setChannelPower(const int* power) {
+		for (int i = 0; i < CHANNELS; i++) {
+			_power[i] = (power[i] > 0) ? power[i] : 0;
+		}
+	}
+
+	/**
+	 * Copies the power of each channel at full duty into the specified array
+	 *
+	 * @param int[]	power	array of CHANNELS
+	 */
+	void	getChannelPower(int* power) {
+		for (int i = 0; i < CHANNELS; i++) {
+			power[i] = _power[i];
+		}
+	}
+
+	/**
+	 * Scale the duties down if the budget is exceeded
+	 *
+	 * @param int[]	duty	duties of CHANNELS
+	 * @param long	maxduty	duty representing full output
+	 * @retval true		the output was limited
+	 * @retval false	the output is within the budget
+	 */
+	bool	limit(int* duty, long maxduty) {
+		if (_budget == 0) return false;
+
+		_stats.frames++;
+		uint64_t load = 0;
+		for (int i = 0; i < CHANNELS; i++) {
+			load += uint64_t(_power[i]) * uint32_t(duty[i]);
+		}
+		uint64_t allowed = uint64_t(_budget) * uint32_t(maxduty);
+		if (load <= allowed) {
+			_stats.lastscale = 1000;
+			return false;
+		}
+
+		// scale factor (16bit fixed point) - only divide when limiting
+		uint32_t scale = uint32_t((allowed << 16) / load);
+		for (int i = 0; i < CHANNELS; i++) {
+			duty[i] = int((uint32_t(duty[i]) * uint64_t(scale)) >> 16);
+		}
+		traceRGBW(TRACE_POWERLIMIT, scale);
+
+		_stats.limited++;
+		_stats.lastscale = uint16_t((scale * 1000) >> 16);
+		if (_stats.lastscale < _stats.minscale) {
+			_stats.minscale = _stats.lastscale;
+		}
+		return true;
+	}
+
+	/**
+	 * Returns the statistics of the limiter
+	 *
+	 * @return RGBWWPowerStats
+	 */
+	RGBWWPowerStats getStats() {
+		return _stats;
+	}
+
+	/**
+	 * Reset the statistics of the limiter
+	 *
+	 */
+	void	resetStats() {
+		_stats.frames = 0;
+		_stats.limited = 0;
+		_stats.lastscale = 1000;
+		_stats.minscale = 1000;
+	}
+
+protected:
+	int		_budget;
+	int		_power[CHANNELS];
+	RGBWWPowerStats _stats;
+};
+
+
+/**
+ * Power limiter of the five RGBWW channels
+ *
+ */
+class RGBWWPowerLimiter : public RGBWWChannelPowerLimiter<RGBWW_CHANNELS::NUM_CHANNELS>
+{
+public:
+	using RGBWWChannelPowerLimiter::setChannelPower;
+	using RGBWWChannelPowerLimiter::getChannelPower;
+
+	/**
+	 * Set the power of each channel at full duty
+	 * (same unit as the budget, i.e. mW)
+	 *
+	 * @param int	r
+	 * @param int	g
+	 * @param int	b
+	 * @param int	ww
+	 * @param int	cw
+	 */
+	void	setChannelPower(int r, int g, int b, int ww, int cw);
+
+	/**
+	 * Copies the power of each channel at full duty into the specified variables
+	 *
+	 * @param int&	r
+	 * @param int&	g
+	 * @param int&	b
+	 * @param int&	ww
+	 * @param int&	cw
+	 */
+	void	getChannelPower(int& r, int& g, int& b, int& ww, int& cw);
+};
+
 #endif //RGBWWLedOutput_h
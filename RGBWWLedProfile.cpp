@@ -0,0 +1,64 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ */
+
+#include "RGBWWLed.h"
+
+#ifdef RGBWW_PROFILE
+
+RGBWWProfileStats RGBWWProfiler::_stats[RGBWW_PROFILE_STAGE::NUM_PROFILE_STAGES];
+
+static const char* const _profileNames[RGBWW_PROFILE_STAGE::NUM_PROFILE_STAGES] = {
+	"frame",
+	"animation",
+	"hsvtorgb",
+	"whitebalance",
+	"brightness",
+	"dimcurve",
+	"output"
+};
+
+
+void RGBWWProfiler::record(RGBWW_PROFILE_STAGE stage, uint32_t cycles) {
+	RGBWWProfileStats& stats = _stats[stage];
+	if (stats.count == 0 || cycles < stats.min) {
+		stats.min = cycles;
+	}
+	if (cycles > stats.max) {
+		stats.max = cycles;
+	}
+	stats.count++;
+	stats.total += cycles;
+
+	// log2 bucket
+	int bucket = 0;
+	if (cycles >> (RGBWW_PROFILE_MINBITS + 1)) {
+		bucket = 31 - __builtin_clz(cycles) - RGBWW_PROFILE_MINBITS;
+		if (bucket >= RGBWW_PROFILE_BUCKETS) {
+			bucket = RGBWW_PROFILE_BUCKETS - 1;
+		}
+	}
+	stats.histogram[bucket]++;
+}
+
+const RGBWWProfileStats& RGBWWProfiler::getStats(RGBWW_PROFILE_STAGE stage) {
+	return _stats[stage];
+}
+
+uint32_t RGBWWProfiler::getBucketMin(int bucket) {
+	return (bucket <= 0) ? 0 : (1UL << (bucket + RGBWW_PROFILE_MINBITS));
+}
+
+const char* RGBWWProfiler::getName(RGBWW_PROFILE_STAGE stage) {
+	return _profileNames[stage];
+}
+
+void RGBWWProfiler::reset() {
+	memset(_stats, 0, sizeof(_stats));
+}
+
+#endif // RGBWW_PROFILE
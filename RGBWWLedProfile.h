@@ -0,0 +1,167 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ */
+
+#ifndef RGBWWLedProfile_h
+#define RGBWWLedProfile_h
+
+/*
+ * Cycle counts of the output pipeline stages
+ *
+ * Compiled in with -DRGBWW_PROFILE, without it the RGBWW_PROFILE_*
+ * macros are empty and nothing is measured.
+ *
+ * The counters are global - with several controllers the
+ * stages of all controllers are summed up.
+ */
+#ifdef RGBWW_PROFILE
+
+#if !defined(__XTENSA__) && (defined(__x86_64__) || defined(__i386__))
+	#include <x86intrin.h>
+#elif !defined(__XTENSA__)
+	#include <chrono>
+#endif
+
+/*
+ * histogram buckets double in width - bucket 0 holds everything
+ * below 2^(RGBWW_PROFILE_MINBITS + 1) cycles, the last bucket
+ * everything above its lower bound
+ */
+#ifndef RGBWW_PROFILE_BUCKETS
+	#define RGBWW_PROFILE_BUCKETS 16
+#endif
+#ifndef RGBWW_PROFILE_MINBITS
+	#define RGBWW_PROFILE_MINBITS 6
+#endif
+
+
+enum RGBWW_PROFILE_STAGE {
+	PROFILE_FRAME = 0,			// RGBWWLed::show() with an animation step
+	PROFILE_ANIMATION = 1,		// bresenham stepping of the transitions
+	PROFILE_HSVTORGB = 2,
+	PROFILE_WHITEBALANCE = 3,
+	PROFILE_BRIGHTNESS = 4,		// calibration and brightness correction
+	PROFILE_DIMCURVE = 5,		// dim curve and power limiter
+	PROFILE_OUTPUT = 6,			// output backend (i.e. pwm_set_duty/pwm_start)
+	NUM_PROFILE_STAGES = 7
+};
+
+
+/**
+ * Cycle counts of a pipeline stage
+ *
+ */
+struct RGBWWProfileStats {
+	uint32_t	count;
+	uint32_t	min;
+	uint32_t	max;
+	uint64_t	total;
+	uint32_t	histogram[RGBWW_PROFILE_BUCKETS];
+
+	uint32_t	avg() const { return count ? uint32_t(total / count) : 0; }
+};
+
+
+/**
+ * Collects the cycle counts of the pipeline stages
+ *
+ * Cycles are read from the ccount register on the ESP8266 and with
+ * rdtsc on x86 hosts, other hosts count nanoseconds of steady_clock.
+ *
+ */
+class RGBWWProfiler
+{
+public:
+	/**
+	 * Current value of the cycle counter
+	 *
+	 * @return uint32_t
+	 */
+	static inline uint32_t cycles() {
+#if defined(__XTENSA__)
+		uint32_t ccount;
+		asm volatile("rsr %0, ccount" : "=a"(ccount));
+		return ccount;
+#elif defined(__x86_64__) || defined(__i386__)
+		return uint32_t(__rdtsc());
+#else
+		return uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	/**
+	 * Add a measurement to a stage
+	 *
+	 * @param RGBWW_PROFILE_STAGE	stage
+	 * @param uint32_t				cycles
+	 */
+	static void record(RGBWW_PROFILE_STAGE stage, uint32_t cycles);
+
+	/**
+	 * Returns the statistics of a stage
+	 *
+	 * @param RGBWW_PROFILE_STAGE	stage
+	 * @return RGBWWProfileStats
+	 */
+	static const RGBWWProfileStats& getStats(RGBWW_PROFILE_STAGE stage);
+
+	/**
+	 * Lower bound (in cycles) of a histogram bucket
+	 *
+	 * @param int	bucket
+	 * @return uint32_t
+	 */
+	static uint32_t getBucketMin(int bucket);
+
+	/**
+	 * Name of a stage (i.e. for printing the statistics)
+	 *
+	 * @param RGBWW_PROFILE_STAGE	stage
+	 * @return const char*
+	 */
+	static const char* getName(RGBWW_PROFILE_STAGE stage);
+
+	/**
+	 * Reset the statistics of all stages
+	 *
+	 */
+	static void reset();
+
+private:
+	static RGBWWProfileStats _stats[RGBWW_PROFILE_STAGE::NUM_PROFILE_STAGES];
+};
+
+
+/**
+ * Records the cycles from construction to the end of the scope
+ *
+ */
+class RGBWWProfileScope
+{
+public:
+	RGBWWProfileScope(RGBWW_PROFILE_STAGE stage) : _stage(stage), _start(RGBWWProfiler::cycles()) {};
+	~RGBWWProfileScope() { RGBWWProfiler::record(_stage, RGBWWProfiler::cycles() - _start); };
+
+private:
+	RGBWW_PROFILE_STAGE	_stage;
+	uint32_t	_start;
+};
+
+
+	#define RGBWW_PROFILE_BEGIN(stage) uint32_t _profile_##stage = RGBWWProfiler::cycles()
+	#define RGBWW_PROFILE_END(stage) RGBWWProfiler::record(RGBWW_PROFILE_STAGE::stage, RGBWWProfiler::cycles() - _profile_##stage)
+	#define RGBWW_PROFILE_SCOPE(stage) RGBWWProfileScope _profile_scope_##stage(RGBWW_PROFILE_STAGE::stage)
+#else
+
+	#define RGBWW_PROFILE_BEGIN(stage)
+	#define RGBWW_PROFILE_END(stage)
+	#define RGBWW_PROFILE_SCOPE(stage)
+
+#endif // RGBWW_PROFILE
+
+#endif //RGBWWLedProfile_h
@@ -0,0 +1,264 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ */
+
+#include "RGBWWLedSequence.h"
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+/**************************************************************
+ *               sequence decoder
+ **************************************************************/
+
+RGBWWSequence::RGBWWSequence() {
+	_data = NULL;
+	_values = NULL;
+	_length = 0;
+	_channels = 0;
+	_frames = 0;
+	_fps = 0;
+	_depth = 0;
+	rewind();
+}
+
+RGBWWSequence::~RGBWWSequence() {
+	delete[] _values;
+}
+
+bool RGBWWSequence::open(const uint8_t* data, uint32_t length) {
+	_data = data;
+	_length = length;
+	if (length < RGBWW_SEQUENCE_HEADERSIZE ||
+			readByte(0) != 'R' || readByte(1) != 'W' || readByte(2) != 'S' || readByte(3) != 'Q' ||
+			readByte(4) != RGBWW_SEQUENCE_VERSION) {
+		_length = 0;
+		return false;
+	}
+	_depth = constrain(readByte(5), 1, 16);
+	int channels = readUint16(6);
+	_fps = readUint16(8);
+	_frames = readUint16(12) | (uint32_t(readUint16(14)) << 16);
+	if (channels != _channels) {
+		delete[] _values;
+		_channels = channels;
+		_values = new uint16_t[_channels];
+	}
+	rewind();
+	return true;
+}
+
+void RGBWWSequence::rewind() {
+	_offset = RGBWW_SEQUENCE_HEADERSIZE;
+	_frame = 0;
+	for (int i = 0; i < _channels; i++) {
+		_values[i] = 0;
+	}
+}
+
+bool RGBWWSequence::nextFrame() {
+	if (_frame >= _frames) {
+		return false;
+	}
+	// values outside of the depth are corrupt data
+	const int maxval = (1 << _depth) - 1;
+	int channel = 0;
+	uint32_t offset = _offset;
+	while (channel < _channels) {
+		if (offset >= _length) {
+			return false;
+		}
+		uint8_t run = readByte(offset++);
+		int count = (run & (RGBWW_SEQUENCE_MAXRUN - 1)) + 1;
+		if (channel + count > _channels) {
+			return false;
+		}
+		switch (run & 0xC0) {
+		case RGBWW_SEQUENCE_SKIP:
+			break;
+		case RGBWW_SEQUENCE_DELTA:
+			if (offset + count > _length) {
+				return false;
+			}
+			for (int i = channel; i < channel + count; i++) {
+				int value = _values[i] + int8_t(readByte(offset++));
+				if (value < 0 || value > maxval) {
+					return false;
+				}
+				_values[i] = value;
+			}
+			break;
+		case RGBWW_SEQUENCE_VALUE:
+			if (offset + 2 * count > _length) {
+				return false;
+			}
+			for (int i = channel; i < channel + count; i++) {
+				int value = readUint16(offset);
+				if (value > maxval) {
+					return false;
+				}
+				_values[i] = value;
+				offset += 2;
+			}
+			break;
+		default:
+			return false;
+		}
+		channel += count;
+	}
+	_offset = offset;
+	_frame++;
+	return true;
+}
+
+int RGBWWSequence::getValue(int channel) {
+	if (channel >= _channels) {
+		return 0;
+	}
+	int value = _values[channel];
+	if (_depth == RGBWW_CALC_DEPTH) {
+		return value;
+	}
+	if (_depth > RGBWW_CALC_DEPTH) {
+		return value >> (_depth - RGBWW_CALC_DEPTH);
+	}
+	return (long(value) * RGBWW_CALC_MAXVAL) / ((1 << _depth) - 1);
+}
+
+int RGBWWSequence::getRawValue(int channel) {
+	return (channel < _channels) ? _values[channel] : 0;
+}
+
+int RGBWWSequence::getChannels() {
+	return _channels;
+}
+
+int RGBWWSequence::getFrameRate() {
+	return _fps;
+}
+
+uint32_t RGBWWSequence::getFrames() {
+	return _frames;
+}
+
+uint32_t RGBWWSequence::getPosition() {
+	return _frame;
+}
+
+
+
+/**************************************************************
+ *               sequence playback
+ **************************************************************/
+
+RGBWWSequenceAnimation::RGBWWSequenceAnimation(const uint8_t* data, uint32_t length, RGBWWLed* ctrl, bool loop /* = false */) {
+	rgbwwctrl = ctrl;
+	_loop = loop;
+	_speed = 100;
+	_valid = _sequence.open(data, length) && _sequence.getFrameRate() > 0;
+	reset();
+}
+
+bool RGBWWSequenceAnimation::run() {
+	if (!_valid) {
+		return true;
+	}
+	if (_sequence.getPosition() == 0) {
+		if (!_sequence.nextFrame()) {
+			return true;
+		}
+	} else {
+		// advance by the elapsed time - _time counts in 1/(fps * speed) ms
+		_time += RGBWW_MINTIMEDIFF * _sequence.getFrameRate() * _speed;
+		while (_time >= 1000L * 100) {
+			_time -= 1000L * 100;
+			if (!_sequence.nextFrame()) {
+				if (!_loop) {
+					return true;
+				}
+				_sequence.rewind();
+				if (!_sequence.nextFrame()) {
+					return true;
+				}
+			}
+		}
+	}
+	ChannelOutput output(_sequence.getValue(RGBWW_CHANNELS::RED),
+						 _sequence.getValue(RGBWW_CHANNELS::GREEN),
+						 _sequence.getValue(RGBWW_CHANNELS::BLUE),
+						 _sequence.getValue(RGBWW_CHANNELS::WW),
+						 _sequence.getValue(RGBWW_CHANNELS::CW));
+	rgbwwctrl->setOutput(output);
+	return false;
+}
+
+void RGBWWSequenceAnimation::reset() {
+	_sequence.rewind();
+	_time = 0;
+}
+
+void RGBWWSequenceAnimation::setSpeed(int newspeed) {
+	_speed = constrain(newspeed, 1, 1000);
+}
+
+
+
+#ifdef __linux__
+/**************************************************************
+ *               memory mapped file
+ **************************************************************/
+
+RGBWWMappedFile::RGBWWMappedFile() {
+	_data = NULL;
+	_length = 0;
+}
+
+RGBWWMappedFile::~RGBWWMappedFile() {
+	close();
+}
+
+bool RGBWWMappedFile::open(const char* path) {
+	close();
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	_data = (const uint8_t*)data;
+	_length = st.st_size;
+	return true;
+}
+
+void RGBWWMappedFile::close() {
+	if (_data != NULL) {
+		munmap((void*)_data, _length);
+		_data = NULL;
+		_length = 0;
+	}
+}
+
+const uint8_t* RGBWWMappedFile::getData() {
+	return _data;
+}
+
+uint32_t RGBWWMappedFile::getLength() {
+	return _length;
+}
+#endif
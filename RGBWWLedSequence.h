@@ -0,0 +1,202 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ */
+
+#ifndef RGBWWLedSequence_h
+#define RGBWWLedSequence_h
+#include "RGBWWLed.h"
+
+/*
+ * Binary frame sequence (little endian)
+ *
+ * header (16 bytes)
+ *	0	"RWSQ"
+ *	4	uint8	version (1)
+ *	5	uint8	depth - bits of the channel values (1 - 16)
+ *	6	uint16	channels
+ *	8	uint16	frames per second
+ *	10	uint16	reserved (0)
+ *	12	uint32	number of frames
+ *
+ * frames follow the header. Each frame is a list of runs covering all
+ * channels. A run starts with one byte - type (bit 7-6) and the
+ * number of channels - 1 (bit 5-0):
+ *	00	SKIP	channels keep the value of the previous frame
+ *	01	DELTA	one signed byte per channel added to the previous value
+ *	10	VALUE	one uint16 per channel
+ * The previous values of the first frame are 0. Values (after adding
+ * a delta) have to be in the range of [0, 2^depth - 1]
+ *
+ * see extras/sequence_encoder.py
+ */
+#define RGBWW_SEQUENCE_HEADERSIZE	16
+#define RGBWW_SEQUENCE_VERSION		1
+
+#define RGBWW_SEQUENCE_SKIP			0x00
+#define RGBWW_SEQUENCE_DELTA		0x40
+#define RGBWW_SEQUENCE_VALUE		0x80
+#define RGBWW_SEQUENCE_MAXRUN		64
+
+#ifndef pgm_read_byte
+	#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#endif
+
+
+/**
+ * Decoder for binary frame sequences
+ *
+ * Frames are decoded directly from the sequence data, which can be
+ * in flash (PROGMEM) or a memory mapped file (see RGBWWMappedFile).
+ * Only the values of the current frame are kept in ram.
+ *
+ */
+class RGBWWSequence
+{
+public:
+	RGBWWSequence();
+	~RGBWWSequence();
+
+	/**
+	 * Open a sequence
+	 *
+	 * @param uint8_t*	data	sequence including the header
+	 * @param uint32_t	length
+	 * @retval true		valid sequence header
+	 * @retval false	invalid sequence
+	 */
+	bool	open(const uint8_t* data, uint32_t length);
+
+	/**
+	 * Decode the next frame
+	 *
+	 * @retval true		frame decoded
+	 * @retval false	end of the sequence (or corrupt data, i.e. values
+	 *					out of the range of the depth)
+	 */
+	bool	nextFrame();
+
+	/**
+	 * Start again with the first frame
+	 *
+	 */
+	void	rewind();
+
+	/**
+	 * Returns the value of a channel in the current frame
+	 * scaled to [0, RGBWW_CALC_MAXVAL]
+	 *
+	 * @param int	channel
+	 * @return int	0 for channels not in the sequence
+	 */
+	int		getValue(int channel);
+
+	/**
+	 * Returns the value of a channel in the current frame
+	 * as stored in the sequence ([0, 2^depth - 1])
+	 *
+	 * @param int	channel
+	 * @return int
+	 */
+	int		getRawValue(int channel);
+
+	int			getChannels();
+	int			getFrameRate();
+	uint32_t	getFrames();
+
+	/**
+	 * Index of the current frame
+	 *
+	 * @return uint32_t
+	 */
+	uint32_t	getPosition();
+
+private:
+	const uint8_t*	_data;
+	uint32_t	_length;
+	uint32_t	_offset;
+	uint32_t	_frame;
+	uint32_t	_frames;
+	uint16_t*	_values;
+	int			_channels;
+	int			_fps;
+	int			_depth;
+
+	inline uint8_t	readByte(uint32_t offset) { return pgm_read_byte(_data + offset); }
+	inline uint16_t	readUint16(uint32_t offset) { return readByte(offset) | (readByte(offset + 1) << 8); }
+};
+
+
+/**
+ * Plays a frame sequence on a controller
+ *
+ * The first five channels of the sequence are mapped to red, green, blue,
+ * warm white and cold white. Frames are skipped or held to keep the frame
+ * rate of the sequence independent of RGBWW_UPDATEFREQUENCY.
+ *
+ */
+class RGBWWSequenceAnimation: public RGBWWLedAnimation
+{
+public:
+	/**
+	 * @param uint8_t*	data	sequence data - has to stay valid while playing
+	 * @param uint32_t	length
+	 * @param RGBWWLed*	ctrl
+	 * @param bool		loop	restart at the end of the sequence
+	 */
+	RGBWWSequenceAnimation(const uint8_t* data, uint32_t length, RGBWWLed* ctrl, bool loop = false);
+
+	bool run();
+	void reset();
+
+	/**
+	 * Playback speed in percent (100 = frame rate of the sequence)
+	 *
+	 * @param int	newspeed
+	 */
+	void setSpeed(int newspeed);
+
+private:
+	RGBWWSequence	_sequence;
+	RGBWWLed*	rgbwwctrl;
+	bool		_loop;
+	bool		_valid;
+	int			_speed;
+	uint32_t	_time;
+};
+
+
+#ifdef __linux__
+/**
+ * Read only memory mapping of a file on linux hosts
+ *
+ */
+class RGBWWMappedFile
+{
+public:
+	RGBWWMappedFile();
+	~RGBWWMappedFile();
+
+	/**
+	 * Map a file into memory
+	 *
+	 * @param char*	path
+	 * @retval true		file mapped
+	 * @retval false	file could not be opened/mapped
+	 */
+	bool	open(const char* path);
+	void	close();
+
+	const uint8_t*	getData();
+	uint32_t		getLength();
+
+private:
+	const uint8_t*	_data;
+	uint32_t		_length;
+};
+#endif
+
+#endif //RGBWWLedSequence_h
@@ -0,0 +1,109 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ */
+
+#include "RGBWWLed.h"
+
+#ifdef RGBWW_TRACE
+
+// keeps the compiler from reordering the record and its sequence number
+#define RGBWW_TRACE_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+#ifdef ARDUINO
+	#define RGBWW_TRACE_PRINTF Serial.printf
+#else
+	#define RGBWW_TRACE_PRINTF printf
+#endif
+
+RGBWWTraceRecord RGBWWTrace::_ring[RGBWW_TRACE_SIZE];
+volatile uint32_t RGBWWTrace::_head = 0;
+volatile uint32_t RGBWWTrace::_epoch = 0;
+
+static const char* const _traceNames[RGBWW_TRACE_EVENT::NUM_TRACE_EVENTS] = {
+	"unknown",
+	"output",
+	"pwm",
+	"hsvtorgb",
+	"hsv.current",
+	"hsv.final",
+	"raw.current",
+	"raw.final",
+	"powerlimit"
+};
+
+
+void RGBWWTrace::record(uint16_t event, int32_t a0, int32_t a1, int32_t a2, int32_t a3, int32_t a4) {
+	uint32_t index = _head;
+	_head = index + 1;
+	RGBWWTraceRecord& record = _ring[index & (RGBWW_TRACE_SIZE - 1)];
+	record.seq = 0;
+	RGBWW_TRACE_BARRIER();
+	record.time = micros();
+	record.event = event;
+	record.reserved = 0;
+	record.arg[0] = a0;
+	record.arg[1] = a1;
+	record.arg[2] = a2;
+	record.arg[3] = a3;
+	record.arg[4] = a4;
+	RGBWW_TRACE_BARRIER();
+	record.seq = index + 1;
+}
+
+int RGBWWTrace::read(RGBWWTraceRecord* records, int max, uint32_t& next) {
+	uint32_t epoch = _epoch;
+	uint32_t head = _head;
+	if (head - next > RGBWW_TRACE_SIZE) {
+		// oldest records were overwritten
+		next = head - RGBWW_TRACE_SIZE;
+	}
+	if (int32_t(next - epoch) < 0) {
+		// clear() ran after next was saved - continue with the
+		// records written since
+		next = epoch;
+	}
+	int count = 0;
+	while (next != head && count < max) {
+		const RGBWWTraceRecord& record = _ring[next & (RGBWW_TRACE_SIZE - 1)];
+		records[count] = record;
+		RGBWW_TRACE_BARRIER();
+		// skip records being written or overwritten while copying
+		if (records[count].seq == next + 1 && record.seq == next + 1) {
+			count++;
+		}
+		next++;
+	}
+	return count;
+}
+
+void RGBWWTrace::dump() {
+	RGBWWTraceRecord records[8];
+	uint32_t next = _epoch;
+	int count;
+	while ((count = read(records, 8, next)) > 0) {
+		for (int i = 0; i < count; i++) {
+			const RGBWWTraceRecord& r = records[i];
+			RGBWW_TRACE_PRINTF("%u %u %s %i %i %i %i %i\r\n", (unsigned int)(r.seq - 1), (unsigned int)r.time,
+					getName(r.event), (int)r.arg[0], (int)r.arg[1], (int)r.arg[2], (int)r.arg[3], (int)r.arg[4]);
+		}
+	}
+}
+
+const char* RGBWWTrace::getName(uint16_t event) {
+	return (event < RGBWW_TRACE_EVENT::NUM_TRACE_EVENTS) ? _traceNames[event] : _traceNames[0];
+}
+
+uint32_t RGBWWTrace::getCount() {
+	return _head - _epoch;
+}
+
+void RGBWWTrace::clear() {
+	memset(_ring, 0, sizeof(_ring));
+	_epoch = _head;
+}
+
+#endif // RGBWW_TRACE
@@ -0,0 +1,133 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ */
+
+#ifndef RGBWWLedTrace_h
+#define RGBWWLedTrace_h
+
+/*
+ * Binary event trace of the hot paths (output pipeline, transitions)
+ *
+ * Compiled in with -DRGBWW_TRACE, without it traceRGBW() is empty.
+ * Unlike debugRGBW nothing is formatted or printed while tracing -
+ * events are stored in a ring buffer and formatted later with
+ * RGBWWTrace::dump() or on a host (see extras/trace_decoder.py)
+ */
+#ifdef RGBWW_TRACE
+
+// number of records in the ring (power of 2)
+#ifndef RGBWW_TRACE_SIZE
+	#define RGBWW_TRACE_SIZE 64
+#endif
+#define RGBWW_TRACE_ARGS 5
+
+static_assert((RGBWW_TRACE_SIZE & (RGBWW_TRACE_SIZE - 1)) == 0, "RGBWW_TRACE_SIZE has to be a power of 2");
+
+
+enum RGBWW_TRACE_EVENT {
+	TRACE_OUTPUT = 1,		// RGBWWLed::setOutput		r, g, b, ww, cw
+	TRACE_PWM = 2,			// PWMOutput::setOutput		r, g, b, ww, cw (duty)
+	TRACE_HSVTORGB = 3,		// HSVtoRGB					r, g, b, w
+	TRACE_HSV_CURRENT = 4,	// HSVTransition::run		h, s, v, ct
+	TRACE_HSV_FINAL = 5,	// HSVTransition::run		h, s, v, ct
+	TRACE_RAW_CURRENT = 6,	// RAWTransition::run		r, g, b, ww, cw
+	TRACE_RAW_FINAL = 7,	// RAWTransition::run		r, g, b, ww, cw
+	TRACE_POWERLIMIT = 8,	// RGBWWPowerLimiter		scale (16bit fixed point)
+	NUM_TRACE_EVENTS = 9
+};
+
+
+/**
+ * Trace record (32 bytes, little endian on all targets)
+ *
+ */
+struct RGBWWTraceRecord {
+	uint32_t	seq;		// number of the record + 1, 0 while it is written
+	uint32_t	time;		// micros()
+	uint16_t	event;		// RGBWW_TRACE_EVENT
+	uint16_t	reserved;
+	int32_t		arg[RGBWW_TRACE_ARGS];
+};
+
+
+/**
+ * Ring buffer of trace records
+ *
+ * Records are written by a single writer (the code running the
+ * controller) without locks. Readers detect records overwritten
+ * while reading by their sequence number and skip them.
+ *
+ * Record numbers keep counting across clear(), which starts a new
+ * epoch at the next record number. Readers holding a number from
+ * before the clear continue at the start of the epoch.
+ *
+ */
+class RGBWWTrace
+{
+public:
+	/**
+	 * Add a record - overwrites the oldest record if the ring is full
+	 *
+	 * @param uint16_t	event	RGBWW_TRACE_EVENT
+	 * @param int32_t	a0 - a4	arguments
+	 */
+	static void record(uint16_t event, int32_t a0 = 0, int32_t a1 = 0, int32_t a2 = 0, int32_t a3 = 0, int32_t a4 = 0);
+
+	/**
+	 * Copy records to a buffer, starting at record number next
+	 * Records no longer in the ring are skipped. A next before the
+	 * last clear() starts at the first record after the clear
+	 *
+	 * @param RGBWWTraceRecord*	records
+	 * @param int				max		size of records
+	 * @param uint32_t&			next	number of the first record to read,
+	 * 									updated to the record following the last one read
+	 * @return int	number of records copied
+	 */
+	static int read(RGBWWTraceRecord* records, int max, uint32_t& next);
+
+	/**
+	 * Print all records in the ring (Serial on Arduino, stdout otherwise)
+	 *
+	 */
+	static void dump();
+
+	/**
+	 * Name of an event
+	 *
+	 * @param uint16_t	event
+	 * @return const char*
+	 */
+	static const char* getName(uint16_t event);
+
+	/**
+	 * Number of records written since the last clear()
+	 *
+	 * @return uint32_t
+	 */
+	static uint32_t getCount();
+
+	/**
+	 * Remove all records
+	 *
+	 */
+	static void clear();
+
+private:
+	static RGBWWTraceRecord _ring[RGBWW_TRACE_SIZE];
+	static volatile uint32_t _head;
+	static volatile uint32_t _epoch;	// number of the first record after the last clear()
+};
+
+	#define traceRGBW(event, ...) RGBWWTrace::record(RGBWW_TRACE_EVENT::event, ##__VA_ARGS__)
+#else
+
+	#define traceRGBW(...)
+
+#endif // RGBWW_TRACE
+
+#endif //RGBWWLedTrace_h
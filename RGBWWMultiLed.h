@@ -0,0 +1,251 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ */
+
+#ifndef RGBWWMultiLed_h
+#define RGBWWMultiLed_h
+#include "RGBWWLed.h"
+
+/**
+ * Controller for an arbitrary number of channels (i.e. RGB + amber + UV
+ * or pwm expanders with 16 channels)
+ *
+ * Channels are faded independently and mapped through the dim curve,
+ * the power limiter and (RGBWW_DITHER_BITS > 0) temporal dithering.
+ * No color conversion, calibration or white balance is applied.
+ * Values are in the range of [0, RGBWW_CALC_MAXVAL].
+ *
+ * Use RGBWWLed for the five RGBWW channels.
+ *
+ * @tparam CHANNELS	number of channels
+ */
+template<int CHANNELS>
+class RGBWWMultiLed
+{
+public:
+	typedef RGBWWChannelValues<CHANNELS> Values;
+
+	RGBWWMultiLed() {
+		_output = NULL;
+		_current_output = Values(0);
+		for (int i = 0; i < CHANNELS; i++) {
+			_frames[0][i] = 0;
+			_frames[1][i] = 0;
+		}
+		_frontFrame = 0;
+#if RGBWW_DITHER_BITS > 0
+		_last_dither = 0;
+#endif
+	}
+
+	/**
+	 * Initialize the controller with an output backend
+	 * The backend is not deleted by the controller
+	 *
+	 * @param output	output backend receiving the channel duties
+	 */
+	void init(RGBWWMultiOutput<CHANNELS>* output) {
+		_output = output;
+	}
+
+	/**
+	 * Main function for processing animations/color output
+	 * Use this in your loop()
+	 *
+	 * When temporal dithering is enabled (RGBWW_DITHER_BITS > 0)
+	 * the dithered output is advanced here as well, show() needs to
+	 * be called at least every RGBWW_DITHER_MINTIMEDIFF ms
+	 *
+	 * @retval true 	not updating
+	 * @retval false 	updates applied
+	 */
+	bool show() {
+	#if RGBWW_DITHER_BITS > 0
+		// advance the dithered output independent of the animation frames
+		if (_output != NULL && millis() - _last_dither >= RGBWW_DITHER_MINTIMEDIFF) {
+			_last_dither = millis();
+			if (_dither.isActive()) {
+				ditherOutput();
+			}
+		}
+	#endif
+
+		RGBWWLedAnimation* animation = _animations.nextFrame();
+		if (animation == NULL) {
+			return true;
+		}
+		if (animation->run()) {
+			_animations.finish();
+		}
+		return false;
+	}
+
+	/**
+	 * Set the output of all channels directly
+	 * Values are constrained to [0, RGBWW_CALC_MAXVAL]
+	 *
+	 * @param output
+	 */
+	void setOutput(const Values& output) {
+		if (_output != NULL) {
+			for (int i = 0; i < CHANNELS; i++) {
+				_current_output[i] = constrain(output[i], 0, RGBWW_CALC_MAXVAL);
+			}
+#if RGBWW_DITHER_BITS > 0
+			int duty[CHANNELS];
+#else
+			int* duty = backFrame();
+#endif
+			for (int i = 0; i < CHANNELS; i++) {
+				duty[i] = RGBWW_dim_curve[_current_output[i]];
+			}
+			powerlimiter.limit(duty, RGBWW_DIM_CURVE_MAXVAL);
+#if RGBWW_DITHER_BITS > 0
+			_dither.setDuties(duty);
+			ditherOutput();
+#else
+			commitFrame();
+#endif
+		}
+	}
+
+	/**
+	 * Returns the current values of all channels
+	 *
+	 * @return Values
+	 */
+	Values getCurrentOutput() {
+		return _current_output;
+	}
+
+	/**
+	 * Returns the pwm duties of the last committed frame
+	 * (after the dim curve, power limiter and dithering)
+	 *
+	 * @return const int*	array of CHANNELS duties
+	 */
+	const int* getOutputFrame() {
+		return _frames[_frontFrame];
+	}
+
+	/**
+	 * Set the output without transition
+	 *
+	 * @param output
+	 * @param queue		add to the animation queue
+	 */
+	void setRAW(const Values& output, bool queue = false) {
+		fadeRAW(output, 0, queue);
+	}
+
+	/**
+	 * Fade from the current output to a new one
+	 *
+	 * @param output
+	 * @param time		duration of the transition in ms
+	 * @param queue		add to the animation queue
+	 */
+	void fadeRAW(const Values& output, int time, bool queue = false) {
+		if (!queue) {
+			_animations.stop();
+		}
+		_animations.push(new RGBWWMultiTransition<CHANNELS>(output, time, this));
+	}
+
+	/**
+	 * Fade from one output to another
+	 *
+	 * @param output_from
+	 * @param output
+	 * @param time		duration of the transition in ms
+	 * @param queue		add to the animation queue
+	 */
+	void fadeRAW(const Values& output_from, const Values& output, int time, bool queue = false) {
+		if (!queue) {
+			_animations.stop();
+		}
+		_animations.push(new RGBWWMultiTransition<CHANNELS>(output_from, output, time, this));
+	}
+
+	/**
+	 * Add an animation to the queue
+	 *
+	 * @param animation
+	 * @retval true		animation was added
+	 * @retval false	queue is full
+	 */
+	bool addToQueue(RGBWWLedAnimation* animation) {
+		return _animations.push(animation);
+	}
+
+	bool isAnimationActive() {
+		return _animations.isActive();
+	}
+
+	bool isAnimationQFull() {
+		return _animations.isFull();
+	}
+
+	void skipAnimation() {
+		_animations.skip();
+	}
+
+	void clearAnimationQueue() {
+		_animations.clear();
+	}
+
+	/**
+	 * Returns the frame timing statistics
+	 *
+	 * @return RGBWWFrameStats
+	 */
+	RGBWWFrameStats getFrameStats() {
+		return _animations.getFrameStats();
+	}
+
+	/**
+	 * Reset the frame timing statistics
+	 *
+	 */
+	void resetFrameStats() {
+		_animations.resetFrameStats();
+	}
+
+	//power budget of the output
+	RGBWWChannelPowerLimiter<CHANNELS> powerlimiter;
+
+private:
+	Values	_current_output;
+	RGBWWAnimationPlayer _animations;
+	RGBWWMultiOutput<CHANNELS>* _output;
+
+	// double buffered output frames - the back frame is
+	// filled by the pipeline and committed as a whole
+	int		_frames[2][CHANNELS];
+	volatile uint8_t _frontFrame;
+
+	int* backFrame() {
+		return _frames[_frontFrame ^ 1];
+	}
+
+	void commitFrame() {
+		_frontFrame ^= 1;
+		_output->setDuties(_frames[_frontFrame]);
+	}
+
+#if RGBWW_DITHER_BITS > 0
+	RGBWWChannelDither<CHANNELS> _dither;
+	unsigned long _last_dither;
+
+	void ditherOutput() {
+		_dither.nextFrame(backFrame());
+		commitFrame();
+	}
+#endif
+};
+
+#endif //RGBWWMultiLed_h
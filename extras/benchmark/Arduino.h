@@ -0,0 +1,50 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Minimal Arduino.h for building the library on a host (see benchmark.cpp)
+ * ARDUINO is not defined - there is no pwm backend and outputs have
+ * to be passed with RGBWWLed::init(RGBWWOutput*)
+ */
+
+#ifndef RGBWW_HOST_ARDUINO_H
+#define RGBWW_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+
+#ifndef constrain
+	#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+#ifdef RGBWW_HOST_SIMCLOCK
+// simulated clock - defined and advanced by the program (i.e. timing tests)
+extern unsigned long hostMicros;
+
+inline unsigned long micros() {
+	return hostMicros;
+}
+#else
+inline unsigned long micros() {
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+#endif
+
+inline unsigned long millis() {
+	return micros() / 1000;
+}
+
+inline void delayMicroseconds(unsigned int us) {
+	unsigned long start = micros();
+	while (micros() - start < us);
+}
+
+#endif //RGBWW_HOST_ARDUINO_H
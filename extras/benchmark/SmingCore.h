@@ -0,0 +1,29 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Stub of SmingCore.h for host builds of the sming backend - only what
+ * the library uses. RGBWWLed.h includes ../../SmingCore/SmingCore.h,
+ * CMakeLists.txt places this file accordingly
+ */
+
+#ifndef RGBWW_HOST_SMINGCORE_H
+#define RGBWW_HOST_SMINGCORE_H
+
+#include <stdint.h>
+
+typedef uint8_t uint8;
+typedef uint32_t uint32;
+
+struct EspDigitalPin {
+	uint32_t	mux;
+	uint8_t		gpioFunc;
+	uint8_t		id;
+};
+
+extern EspDigitalPin EspDigitalPins[];
+
+#endif //RGBWW_HOST_SMINGCORE_H
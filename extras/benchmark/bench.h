@@ -0,0 +1,89 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Helpers of the host benchmarks - results are written as json to stdout:
+ *	{"library": ..., "config": {...}, "results": [{"name", "ops", "ns_per_op"}, ...]}
+ * ns_per_op is the best of BENCH_RUNS runs
+ */
+
+#ifndef RGBWW_BENCH_H
+#define RGBWW_BENCH_H
+
+#include "RGBWWLed.h"
+#include <chrono>
+
+#ifndef BENCH_RUNS
+	#define BENCH_RUNS 5
+#endif
+
+
+// keeps the compiler from removing the benchmarked code
+static volatile int sink;
+
+class NullOutput: public RGBWWOutput
+{
+public:
+	void setOutput(int red, int green, int blue, int warmwhite, int coldwhite) {
+		sink = red + green + blue + warmwhite + coldwhite;
+	}
+};
+
+static bool benchFirst = true;
+
+/**
+ * Start the json output
+ *
+ * @param name	name of the benchmark program
+ */
+static inline void benchBegin(const char* name) {
+	printf("{\n  \"library\": \"RGBWWLed\",\n  \"version\": \"%s\",\n  \"benchmark\": \"%s\",\n", RGBWW_VERSION, name);
+	printf("  \"config\": {\"calc_depth\": %d, \"pwm_resolution\": %ld, \"dither_bits\": %d, \"update_frequency\": %d},\n",
+			RGBWW_CALC_DEPTH, long(RGBWW_PWMRESOLUTION), RGBWW_DITHER_BITS, RGBWW_UPDATEFREQUENCY);
+	printf("  \"results\": [");
+}
+
+static inline void benchEnd() {
+	printf("\n  ]\n}\n");
+}
+
+/**
+ * Print a result which was not measured with bench() (i.e. a rate)
+ *
+ * @param name
+ * @param key		json key of the value
+ * @param value
+ */
+static inline void benchValue(const char* name, const char* key, double value) {
+	printf("%s\n    {\"name\": \"%s\", \"%s\": %.2f}", benchFirst ? "" : ",", name, key, value);
+	benchFirst = false;
+}
+
+/**
+ * Run a benchmark and print the result
+ *
+ * @param name
+ * @param func	runs the benchmarked code, returns the number of operations
+ * @return double	ns per operation
+ */
+template<typename F>
+static double bench(const char* name, F func) {
+	double best = 0;
+	long ops = 0;
+	for (int run = 0; run < BENCH_RUNS; run++) {
+		auto start = std::chrono::steady_clock::now();
+		ops = func();
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		if (run == 0 || ns < best) {
+			best = ns;
+		}
+	}
+	printf("%s\n    {\"name\": \"%s\", \"ops\": %ld, \"ns_per_op\": %.2f}", benchFirst ? "" : ",", name, ops, best / ops);
+	benchFirst = false;
+	return best / ops;
+}
+
+#endif //RGBWW_BENCH_H
@@ -0,0 +1,200 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Host benchmark of the color and animation engine
+ *
+ * Built with CMakeLists.txt in this directory, results are written
+ * as json to stdout (see bench.h)
+ */
+
+#include "bench.h"
+
+
+/**************************************************************
+ *                 color conversion
+ **************************************************************/
+
+// hue over the full wheel (about 1536 steps), saturation and value in 16 steps each
+static long hsvDomain(RGBWWColorUtils& utils, RGBWW_HSVMODEL model) {
+	const int step = (RGBWW_CALC_MAXVAL + 15) / 16;
+	const int hueStep = (RGBWW_CALC_HUEWHEELMAX + 1535) / 1536;
+	long ops = 0;
+	RGBWCT rgbw;
+	HSVCT hsv;
+	hsv.ct = 0;
+	for (int s = 0; s <= RGBWW_CALC_MAXVAL; s += step) {
+		for (int v = 0; v <= RGBWW_CALC_MAXVAL; v += step) {
+			for (int h = 0; h <= RGBWW_CALC_HUEWHEELMAX; h += hueStep) {
+				hsv.h = h;
+				hsv.s = s;
+				hsv.v = v;
+				utils.HSVtoRGB(hsv, rgbw, model);
+				sink = rgbw.r;
+				ops++;
+			}
+		}
+	}
+	return ops;
+}
+
+// color temperatures from warm white to cold white (and ct = 0)
+static long whiteBalanceDomain(RGBWWColorUtils& utils) {
+	const int step = (RGBWW_CALC_MAXVAL + 31) / 32;
+	long ops = 0;
+	ChannelOutput output;
+	for (int ct = RGBWW_WARMWHITEKELVIN - 100; ct <= RGBWW_COLDWHITEKELVIN + 100; ct += 100) {
+		for (int c = 0; c <= RGBWW_CALC_MAXVAL; c += step) {
+			for (int w = 0; w <= RGBWW_CALC_MAXVAL; w += step) {
+				RGBWCT rgbw(c, RGBWW_CALC_MAXVAL - c, c / 2, w, (ct < RGBWW_WARMWHITEKELVIN) ? 0 : ct);
+				utils.whiteBalance(rgbw, output);
+				sink = output.ww;
+				ops++;
+			}
+		}
+	}
+	return ops;
+}
+
+static long brightnessDomain(RGBWWColorUtils& utils) {
+	long ops = 0;
+	for (int i = 0; i <= RGBWW_CALC_MAXVAL; i++) {
+		for (int j = 0; j < 64; j++) {
+			ChannelOutput output(i, RGBWW_CALC_MAXVAL - i, j, i, j);
+			utils.correctBrightness(output);
+			sink = output.r;
+			ops++;
+		}
+	}
+	return ops;
+}
+
+static void benchColor() {
+	static const char* const models[RGBWW_HSVMODEL::NUM_HSVMODELS] = {"raw", "spektrum", "rainbow", "custom"};
+	static const char* const modes[RGBWW_COLORMODE::NUM_COLORMODES] = {"rgb", "rgbww", "rgbcw", "rgbwwcw"};
+	char name[64];
+
+	RGBWWColorUtils utils;
+	for (int model = 0; model < RGBWW_HSVMODEL::NUM_HSVMODELS; model++) {
+		snprintf(name, sizeof(name), "hsvtorgb.%s", models[model]);
+		bench(name, [&]() { return hsvDomain(utils, (RGBWW_HSVMODEL)model); });
+	}
+
+	for (int mode = 0; mode < RGBWW_COLORMODE::NUM_COLORMODES; mode++) {
+		utils.setColorMode((RGBWW_COLORMODE)mode);
+		snprintf(name, sizeof(name), "whitebalance.%s", modes[mode]);
+		bench(name, [&]() { return whiteBalanceDomain(utils); });
+	}
+	utils.setColorMode(RGBWW_COLORMODE::RGB);
+
+	bench("correctbrightness", [&]() { return brightnessDomain(utils); });
+	utils.setBrightnessCorrection(90, 80, 70, 60, 50);
+	bench("correctbrightness.scaled", [&]() { return brightnessDomain(utils); });
+
+	// 5x5 fixed point kernel (identity matrix skips the kernel)
+	const int matrix[RGBWW_CHANNELS::NUM_CHANNELS][RGBWW_CHANNELS::NUM_CHANNELS] = {
+		{ 3768, 164, 0, 0, 0 },
+		{ -246, 3604, 205, 0, 0 },
+		{ 0, -123, 3973, 0, 0 },
+		{ -410, 0, 0, 3891, 0 },
+		{ 0, 0, 82, 0, RGBWW_CALIBRATION_ONE }
+	};
+	utils.setCalibrationMatrix(matrix);
+	bench("calibrate", [&]() {
+		long ops = 0;
+		for (int i = 0; i <= RGBWW_CALC_MAXVAL; i++) {
+			for (int j = 0; j < 64; j++) {
+				ChannelOutput output(i, RGBWW_CALC_MAXVAL - i, j, i, j);
+				utils.calibrate(output);
+				sink = output.r;
+				ops++;
+			}
+		}
+		return ops;
+	});
+	utils.resetCalibrationMatrix();
+}
+
+
+/**************************************************************
+ *                 animation
+ **************************************************************/
+
+// steps of a transition including the output pipeline of the controller
+template<typename T>
+static long runTransition(T& transition) {
+	long ops = 0;
+	transition.reset();
+	while (!transition.run()) {
+		ops++;
+	}
+	return ops + 1;
+}
+
+static void benchAnimation() {
+	NullOutput out;
+	RGBWWLed led;
+	led.init(&out);
+
+	const int time = 1000 * RGBWW_MINTIMEDIFF;
+	HSVCT hsvFrom(0, RGBWW_CALC_MAXVAL, RGBWW_CALC_MAXVAL / 4, RGBWW_WARMWHITEKELVIN);
+	HSVCT hsvTo(RGBWW_CALC_HUEWHEELMAX / 2, RGBWW_CALC_MAXVAL / 2, RGBWW_CALC_MAXVAL, RGBWW_COLDWHITEKELVIN);
+	HSVTransition hsv(hsvFrom, hsvTo, time, 0, &led);
+	bench("transition.hsv", [&]() { return runTransition(hsv); });
+
+	ChannelOutput rawFrom(0, RGBWW_CALC_MAXVAL, 0, RGBWW_CALC_MAXVAL / 2, 0);
+	ChannelOutput rawTo(RGBWW_CALC_MAXVAL, 0, RGBWW_CALC_MAXVAL / 3, 0, RGBWW_CALC_MAXVAL);
+	RAWTransition raw(rawFrom, rawTo, time, &led);
+	bench("transition.raw", [&]() { return runTransition(raw); });
+	RAWTransition rawMired(rawFrom, rawTo, time, &led, true);
+	bench("transition.raw.mired", [&]() { return runTransition(rawMired); });
+}
+
+static void benchQueue() {
+	const int size = RGBWW_ANIMATIONQSIZE;
+	RGBWWLedAnimationQ q(size);
+	RGBWWLedAnimation* animations[size];
+	for (int i = 0; i < size; i++) {
+		animations[i] = new RGBWWLedAnimation();
+	}
+
+	bench("queue.pushpop", [&]() {
+		for (int n = 0; n < 1000; n++) {
+			for (int i = 0; i < size; i++) {
+				q.push(animations[i]);
+			}
+			while (!q.isEmpty()) {
+				sink = (q.pop() != NULL);
+			}
+		}
+		return 1000L * size;
+	});
+
+	// clear deletes the animations - includes the deallocation
+	bench("queue.clear", [&]() {
+		for (int n = 0; n < 100; n++) {
+			for (int i = 0; i < size; i++) {
+				q.push(new RGBWWLedAnimation());
+			}
+			q.clear();
+		}
+		return 100L * size;
+	});
+
+	for (int i = 0; i < size; i++) {
+		delete animations[i];
+	}
+}
+
+
+int main() {
+	benchBegin("engine");
+	benchColor();
+	benchAnimation();
+	benchQueue();
+	benchEnd();
+	return 0;
+}
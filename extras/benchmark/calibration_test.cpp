@@ -0,0 +1,115 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Precision of the fixed point calibration matrix against a
+ * double precision reference
+ *
+ * With the Q12 coefficients the kernel has to round the exact
+ * result to nearest (error <= 0.5). The error against the matrix
+ * before quantization to Q12 is printed for information.
+ */
+
+#include "RGBWWLed.h"
+#include "check.h"
+#include <math.h>
+
+// input values per channel - STEPS^5 combinations
+#define STEPS 13
+
+static const double matrices[][RGBWW_CHANNELS::NUM_CHANNELS][RGBWW_CHANNELS::NUM_CHANNELS] = {
+	// cross talk of the primaries, warm white with a red tint
+	{
+		{ 0.92,  0.04, 0.00, 0.00, 0.00 },
+		{ -0.06, 0.88, 0.05, 0.00, 0.00 },
+		{ 0.00, -0.03, 0.97, 0.00, 0.00 },
+		{ -0.10, 0.00, 0.00, 0.95, 0.00 },
+		{ 0.00,  0.00, 0.02, 0.00, 1.00 }
+	},
+	// gains above 1 - results saturate
+	{
+		{ 1.25, 0.00, 0.00, 0.00, 0.00 },
+		{ 0.00, 1.50, 0.00, 0.00, 0.00 },
+		{ 0.00, 0.00, 0.75, 0.00, 0.00 },
+		{ 0.10, 0.10, 0.10, 1.10, 0.00 },
+		{ 0.00, 0.00, 0.00, 0.30, 0.70 }
+	},
+	// strong negative terms - results clamp at 0
+	{
+		{ 1.00, -0.50, -0.50, 0.00, 0.00 },
+		{ -0.50, 1.00, -0.50, 0.00, 0.00 },
+		{ -0.50, -0.50, 1.00, 0.00, 0.00 },
+		{ 0.00, 0.00, 0.00, 1.00, -1.00 },
+		{ 0.00, 0.00, 0.00, -1.00, 1.00 }
+	}
+};
+
+
+static double clampCalc(double value) {
+	return (value < 0) ? 0 : ((value > RGBWW_CALC_MAXVAL) ? RGBWW_CALC_MAXVAL : value);
+}
+
+static void testMatrix(const double matrix[RGBWW_CHANNELS::NUM_CHANNELS][RGBWW_CHANNELS::NUM_CHANNELS]) {
+	RGBWWColorUtils utils;
+	int fixed[RGBWW_CHANNELS::NUM_CHANNELS][RGBWW_CHANNELS::NUM_CHANNELS];
+	for (int i = 0; i < RGBWW_CHANNELS::NUM_CHANNELS; i++) {
+		for (int j = 0; j < RGBWW_CHANNELS::NUM_CHANNELS; j++) {
+			fixed[i][j] = int(lround(matrix[i][j] * RGBWW_CALIBRATION_ONE));
+		}
+	}
+	utils.setCalibrationMatrix(fixed);
+
+	double maxError = 0;
+	double maxQuantError = 0;
+	int in[RGBWW_CHANNELS::NUM_CHANNELS];
+	long combinations = 1;
+	for (int c = 0; c < RGBWW_CHANNELS::NUM_CHANNELS; c++) {
+		combinations *= STEPS;
+	}
+	for (long n = 0; n < combinations; n++) {
+		long rest = n;
+		for (int c = 0; c < RGBWW_CHANNELS::NUM_CHANNELS; c++) {
+			in[c] = int((rest % STEPS) * RGBWW_CALC_MAXVAL / (STEPS - 1));
+			rest /= STEPS;
+		}
+		ChannelOutput output(in[0], in[1], in[2], in[3], in[4]);
+		utils.calibrate(output);
+		const int out[RGBWW_CHANNELS::NUM_CHANNELS] = { output.r, output.g, output.b, output.ww, output.cw };
+
+		for (int i = 0; i < RGBWW_CHANNELS::NUM_CHANNELS; i++) {
+			double exact = 0;
+			double unquantized = 0;
+			for (int j = 0; j < RGBWW_CHANNELS::NUM_CHANNELS; j++) {
+				exact += double(fixed[i][j]) / RGBWW_CALIBRATION_ONE * in[j];
+				unquantized += matrix[i][j] * in[j];
+			}
+			double error = fabs(out[i] - clampCalc(exact));
+			double quantError = fabs(out[i] - clampCalc(unquantized));
+			maxError = (error > maxError) ? error : maxError;
+			maxQuantError = (quantError > maxQuantError) ? quantError : maxQuantError;
+		}
+	}
+	printf("calc depth %d: max error %.3f, against unquantized matrix %.3f\n", RGBWW_CALC_DEPTH, maxError, maxQuantError);
+	CHECK(maxError <= 0.5);
+	// Q12 coefficients - at most 0.5 / 4096 per coefficient
+	CHECK(maxQuantError <= 0.5 + RGBWW_CHANNELS::NUM_CHANNELS * RGBWW_CALC_MAXVAL * 0.5 / RGBWW_CALIBRATION_ONE);
+}
+
+
+int main() {
+	for (const auto& matrix : matrices) {
+		testMatrix(matrix);
+	}
+
+	// identity - values pass unchanged
+	RGBWWColorUtils utils;
+	ChannelOutput output(1, RGBWW_CALC_MAXVAL, 3, RGBWW_CALC_MAXVAL / 2, 0);
+	utils.calibrate(output);
+	CHECK_EQUAL(output.r, 1);
+	CHECK_EQUAL(output.g, RGBWW_CALC_MAXVAL);
+	CHECK_EQUAL(output.ww, RGBWW_CALC_MAXVAL / 2);
+	return checkResult();
+}
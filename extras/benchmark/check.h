@@ -0,0 +1,42 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Checks of the host tests - failures are printed, checkResult()
+ * returns the exit code of the test program
+ */
+
+#ifndef RGBWW_CHECK_H
+#define RGBWW_CHECK_H
+
+#include <stdio.h>
+
+static int checkFailures = 0;
+static int checkCount = 0;
+
+#define CHECK(cond) do { \
+		checkCount++; \
+		if (!(cond)) { \
+			checkFailures++; \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		} \
+	} while (0)
+
+#define CHECK_EQUAL(a, b) do { \
+		checkCount++; \
+		long _a = long(a), _b = long(b); \
+		if (_a != _b) { \
+			checkFailures++; \
+			printf("%s:%d: check failed: %s == %s (%ld != %ld)\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+		} \
+	} while (0)
+
+static inline int checkResult() {
+	printf("%d checks, %d failed\n", checkCount, checkFailures);
+	return checkFailures ? 1 : 0;
+}
+
+#endif //RGBWW_CHECK_H
@@ -0,0 +1,82 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Effective resolution of the dim curve and temporal dithering stage
+ *
+ * Every calc value is passed through RGBWW_dim_curve and RGBWWDither
+ * and the pwm duties are averaged over WINDOW frames (what the eye
+ * integrates). Built once per RGBWW_DITHER_BITS (see CMakeLists.txt)
+ *
+ *	levels			distinct averaged outputs over all calc values
+ *	effective_bits	log2(levels)
+ *	low_levels		distinct averaged outputs below LOWDUTY duty steps
+ *	max_error		largest difference to the exact curve (in duty steps)
+ *	max_flicker		largest duty change within a window (in duty steps)
+ */
+
+#include "bench.h"
+#include <math.h>
+#include <set>
+
+#define WINDOW		64
+#define LOWDUTY		4
+
+
+int main() {
+	std::set<long> levels;
+	std::set<long> low;
+	double maxError = 0;
+	int maxFlicker = 0;
+	RGBWWDither dither;
+	int duty[RGBWW_CHANNELS::NUM_CHANNELS];
+
+	for (int value = 0; value <= RGBWW_CALC_MAXVAL; value++) {
+		int target = RGBWW_dim_curve[value];
+		dither.setOutput(target, target, target, target, target);
+		// settle the error accumulator
+		for (int i = 0; i < WINDOW; i++) {
+			dither.nextFrame(duty);
+		}
+		long sum = 0;
+		int minDuty = RGBWW_PWMMAXVAL;
+		int maxDuty = 0;
+		for (int i = 0; i < WINDOW; i++) {
+			dither.nextFrame(duty);
+			sum += duty[RGBWW_CHANNELS::RED];
+			minDuty = (duty[RGBWW_CHANNELS::RED] < minDuty) ? duty[RGBWW_CHANNELS::RED] : minDuty;
+			maxDuty = (duty[RGBWW_CHANNELS::RED] > maxDuty) ? duty[RGBWW_CHANNELS::RED] : maxDuty;
+		}
+		// sum is the average in 1/WINDOW duty steps
+		levels.insert(sum);
+		if (sum < LOWDUTY * WINDOW) {
+			low.insert(sum);
+		}
+		double exact = RGBWWConstMath::curve(double(value) / RGBWW_CALC_MAXVAL) * RGBWW_PWMMAXVAL;
+		double error = fabs(double(sum) / WINDOW - exact);
+		maxError = (error > maxError) ? error : maxError;
+		maxFlicker = (maxDuty - minDuty > maxFlicker) ? maxDuty - minDuty : maxFlicker;
+	}
+
+	benchBegin("dither");
+	benchValue("levels", "value", levels.size());
+	benchValue("effective_bits", "value", log2(double(levels.size())));
+	benchValue("low_levels", "value", low.size());
+	benchValue("max_error", "value", maxError);
+	benchValue("max_flicker", "value", maxFlicker);
+
+	// cost of a dithered frame in show()
+	dither.setOutput(1, 2, 3, 4, 5);
+	bench("dither.frame", [&]() {
+		for (int i = 0; i < 1000000; i++) {
+			dither.nextFrame(duty);
+			sink = duty[0];
+		}
+		return 1000000L;
+	});
+	benchEnd();
+	return 0;
+}
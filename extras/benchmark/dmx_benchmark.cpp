@@ -0,0 +1,152 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Packets per second of RGBWWDmxReceiver and frames per second of
+ * RGBWWE131Sender (linux only)
+ *
+ * dmx.process.* - parsing and the output pipeline of the controller
+ * dmx.localhost.* - including the udp receive of packets sent over
+ * the loopback interface in bursts of RGBWW_DMX_MAXBATCH
+ * e131.sender.<n> - one frame of n fading controllers (102 per
+ * universe) sent to a localhost listener
+ */
+
+#include "bench.h"
+#include "dmx_local.h"
+
+#define BENCH_PACKETS 100000L
+#define BENCH_LOCALPACKETS 20000L
+#define BENCH_FRAMES 200L
+
+// controllers in one universe (5 slots each)
+#define CONTROLLERS_PER_UNIVERSE (RGBWW_DMX_CHANNELS / RGBWW_CHANNELS::NUM_CHANNELS)
+
+
+static void benchProcess(const char* name, RGBWWDmxReceiver& receiver, uint8_t* packet, int length, int sequence) {
+	double ns = bench(name, [&]() {
+		for (long i = 0; i < BENCH_PACKETS; i++) {
+			// keep the sequence moving so no packet is dropped
+			packet[sequence]++;
+			sink = receiver.process(packet, length);
+		}
+		return BENCH_PACKETS;
+	});
+	char rate[64];
+	snprintf(rate, sizeof(rate), "%s.rate", name);
+	benchValue(rate, "packets_per_s", 1e9 / ns);
+}
+
+static void benchLocalhost(const char* name, RGBWWDmxReceiver& receiver, uint8_t* packet, int length, int sequence) {
+	LocalSocket tx;
+	LocalSocket rx;
+	uint8_t buffer[1500];
+	long lost = 0;
+	double ns = bench(name, [&]() {
+		for (long i = 0; i < BENCH_LOCALPACKETS; i += RGBWW_DMX_MAXBATCH) {
+			for (int n = 0; n < RGBWW_DMX_MAXBATCH; n++) {
+				packet[sequence]++;
+				tx.sendTo(packet, length, rx.port);
+			}
+			for (int n = 0; n < RGBWW_DMX_MAXBATCH; n++) {
+				int received = rx.receive(buffer, sizeof(buffer));
+				if (received <= 0 || !receiver.process(buffer, received)) {
+					lost++;
+				}
+			}
+		}
+		return BENCH_LOCALPACKETS;
+	});
+	char rate[64];
+	snprintf(rate, sizeof(rate), "%s.rate", name);
+	benchValue(rate, "packets_per_s", 1e9 / ns);
+	snprintf(rate, sizeof(rate), "%s.lost", name);
+	benchValue(rate, "value", lost);
+}
+
+static void benchSender(int controllers) {
+	LocalSocket rx;
+	RGBWWLinuxUdp udp("127.0.0.1", rx.port);
+	int universes = (controllers + CONTROLLERS_PER_UNIVERSE - 1) / CONTROLLERS_PER_UNIVERSE;
+	RGBWWE131Sender sender(&udp, 1, universes);
+
+	RGBWWE131Output** outputs = new RGBWWE131Output*[controllers];
+	RGBWWLed** leds = new RGBWWLed*[controllers];
+	for (int i = 0; i < controllers; i++) {
+		outputs[i] = new RGBWWE131Output(&sender, 1 + i / CONTROLLERS_PER_UNIVERSE,
+										 1 + (i % CONTROLLERS_PER_UNIVERSE) * RGBWW_CHANNELS::NUM_CHANNELS);
+		leds[i] = new RGBWWLed();
+		leds[i]->init(outputs[i]);
+	}
+
+	uint8_t buffer[1500];
+	long received = 0;
+	long sent = 0;
+	int run = 0;
+	char name[64];
+	snprintf(name, sizeof(name), "e131.sender.%d", controllers);
+	double ns = bench(name, [&]() {
+		// every controller fades to another hue in each run
+		run++;
+		for (int i = 0; i < controllers; i++) {
+			HSVCT color((i * 7 + run * RGBWW_CALC_HUEWHEELMAX / 3) % RGBWW_CALC_HUEWHEELMAX, RGBWW_CALC_MAXVAL, RGBWW_CALC_MAXVAL);
+			leds[i]->fadeHSV(color, int(BENCH_FRAMES * RGBWW_MINTIMEDIFF));
+		}
+		for (long frame = 0; frame < BENCH_FRAMES; frame++) {
+			for (int i = 0; i < controllers; i++) {
+				leds[i]->show();
+			}
+			sent += sender.send();
+			while (recv(rx.fd, buffer, sizeof(buffer), MSG_DONTWAIT) > 0) {
+				received++;
+			}
+		}
+		return BENCH_FRAMES;
+	});
+	snprintf(name, sizeof(name), "e131.sender.%d.fps", controllers);
+	benchValue(name, "fps", 1e9 / ns);
+	snprintf(name, sizeof(name), "e131.sender.%d.lost", controllers);
+	benchValue(name, "value", sent - received);
+
+	for (int i = 0; i < controllers; i++) {
+		delete leds[i];
+		delete outputs[i];
+	}
+	delete[] leds;
+	delete[] outputs;
+}
+
+
+int main() {
+	NullOutput out;
+	RGBWWLed led;
+	led.init(&out);
+	RGBWWDmxReceiver receiver(&led, 1, 1);
+
+	uint8_t slots[RGBWW_DMX_CHANNELS];
+	for (int i = 0; i < RGBWW_DMX_CHANNELS; i++) {
+		slots[i] = i;
+	}
+	uint8_t e131[RGBWW_E131_PACKETSIZE];
+	uint8_t artnet[RGBWW_E131_PACKETSIZE];
+	int e131Length = makeE131(e131, 1, 0, slots, RGBWW_DMX_CHANNELS);
+	int artnetLength = makeArtNet(artnet, 1, 0, slots, RGBWW_DMX_CHANNELS);
+	// offsets of the sequence numbers
+	const int e131Sequence = 111;
+	const int artnetSequence = 12;
+
+	benchBegin("dmx");
+	benchProcess("dmx.process.e131", receiver, e131, e131Length, e131Sequence);
+	benchProcess("dmx.process.artnet", receiver, artnet, artnetLength, artnetSequence);
+	receiver.setRaw(true);
+	benchProcess("dmx.process.e131.raw", receiver, e131, e131Length, e131Sequence);
+	receiver.setRaw(false);
+	benchLocalhost("dmx.localhost.e131", receiver, e131, e131Length, e131Sequence);
+	benchSender(100);
+	benchSender(1000);
+	benchEnd();
+	return 0;
+}
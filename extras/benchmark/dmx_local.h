@@ -0,0 +1,111 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Localhost udp socket and dmx packet builders of the dmx host
+ * tests and benchmarks (linux only)
+ */
+
+#ifndef RGBWW_DMX_LOCAL_H
+#define RGBWW_DMX_LOCAL_H
+
+#include "RGBWWLedDmx.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+
+/**
+ * Udp socket bound to an ephemeral port on 127.0.0.1
+ */
+class LocalSocket
+{
+public:
+	int		fd;
+	uint16_t port;
+
+	LocalSocket() {
+		fd = socket(AF_INET, SOCK_DGRAM, 0);
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+		bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+		socklen_t len = sizeof(addr);
+		getsockname(fd, (struct sockaddr*)&addr, &len);
+		port = ntohs(addr.sin_port);
+		struct timeval timeout = { 1, 0 };
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	}
+
+	~LocalSocket() {
+		close(fd);
+	}
+
+	bool sendTo(const uint8_t* data, int length, uint16_t to) {
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = htons(to);
+		return sendto(fd, data, length, 0, (struct sockaddr*)&addr, sizeof(addr)) == length;
+	}
+
+	int receive(uint8_t* data, int length) {
+		return recv(fd, data, length, 0);
+	}
+};
+
+
+// E1.31 data packet built from the field offsets of ANSI E1.31-2016
+static inline int makeE131(uint8_t* data, uint16_t universe, uint8_t sequence, const uint8_t* slots, int count, uint8_t options = 0) {
+	static const uint8_t acn[12] = { 'A', 'S', 'C', '-', 'E', '1', '.', '1', '7', 0, 0, 0 };
+	int length = 126 + count;
+	memset(data, 0, length);
+	data[1] = 0x10;
+	memcpy(data + 4, acn, sizeof(acn));
+	data[16] = 0x70 | ((length - 16) >> 8);
+	data[17] = (length - 16) & 0xFF;
+	data[21] = 0x04;
+	data[38] = 0x70 | ((length - 38) >> 8);
+	data[39] = (length - 38) & 0xFF;
+	data[43] = 0x02;
+	data[108] = 100;
+	data[111] = sequence;
+	data[112] = options;
+	data[113] = universe >> 8;
+	data[114] = universe & 0xFF;
+	data[115] = 0x70 | ((length - 115) >> 8);
+	data[116] = (length - 115) & 0xFF;
+	data[117] = 0x02;
+	data[118] = 0xA1;
+	data[122] = 0x01;
+	data[123] = (count + 1) >> 8;
+	data[124] = (count + 1) & 0xFF;
+	memcpy(data + 126, slots, count);
+	return length;
+}
+
+// Art-Net ArtDmx packet (Art-Net 4)
+static inline int makeArtNet(uint8_t* data, uint16_t universe, uint8_t sequence, const uint8_t* slots, int count) {
+	static const uint8_t id[8] = { 'A', 'r', 't', '-', 'N', 'e', 't', 0 };
+	memset(data, 0, 18);
+	memcpy(data, id, sizeof(id));
+	data[8] = 0x00;
+	data[9] = 0x50;
+	data[11] = 14;
+	data[12] = sequence;
+	data[14] = universe & 0xFF;
+	data[15] = (universe >> 8) & 0x7F;
+	data[16] = count >> 8;
+	data[17] = count & 0xFF;
+	memcpy(data + 18, slots, count);
+	return 18 + count;
+}
+
+#endif //RGBWW_DMX_LOCAL_H
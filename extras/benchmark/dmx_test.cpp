@@ -0,0 +1,239 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * E1.31 and Art-Net packets sent over a localhost udp socket and
+ * passed to RGBWWDmxReceiver, RGBWWE131Sender with a transport
+ * sending only part of the packets and over localhost (linux only)
+ */
+
+#include "dmx_local.h"
+#include "check.h"
+
+
+// duty of a channel in the last recorded frame
+static int lastDuty(RGBWWRecordingOutput& out, int channel) {
+	RGBWWOutputFrame frame;
+	if (!out.getFrame(out.getCount() - 1, frame)) {
+		return -1;
+	}
+	return frame.duty[channel];
+}
+
+
+/**
+ * Transport accepting at most limit packets per call
+ */
+class LimitedTransport: public RGBWWDmxTransport
+{
+public:
+	int		limit;
+	int		calls;
+	uint16_t universes[64];
+	int		count;
+
+	LimitedTransport(int limit) : limit(limit), calls(0), count(0) {}
+
+	int send(const RGBWWDmxPacket* packets, int count) {
+		calls++;
+		int sent = (count < limit) ? count : limit;
+		for (int i = 0; i < sent && this->count < 64; i++) {
+			universes[this->count++] = packets[i].universe;
+		}
+		return sent;
+	}
+};
+
+
+static int dmxDuty(uint8_t value) {
+	return (long(value) * RGBWW_PWMMAXVAL + 127) / 255;
+}
+
+
+static void testParse() {
+	uint8_t slots[RGBWW_DMX_CHANNELS] = { 0 };
+	uint8_t packet[RGBWW_E131_PACKETSIZE];
+	RGBWWDmxFrame frame;
+
+	int length = makeE131(packet, 7, 3, slots, 100);
+	CHECK(RGBWWDmxReceiver::parseE131(packet, length, frame));
+	CHECK_EQUAL(frame.protocol, RGBWW_DMX_PROTOCOL::RGBWW_DMX_E131);
+	CHECK_EQUAL(frame.universe, 7);
+	CHECK_EQUAL(frame.sequence, 3);
+	CHECK_EQUAL(frame.length, 100);
+	CHECK(!RGBWWDmxReceiver::parseArtNet(packet, length, frame));
+	// truncated payload - slots limited to the packet
+	CHECK(RGBWWDmxReceiver::parseE131(packet, length - 10, frame));
+	CHECK_EQUAL(frame.length, 90);
+	CHECK(!RGBWWDmxReceiver::parseE131(packet, 100, frame));
+
+	length = makeArtNet(packet, 0x123, 9, slots, 512);
+	CHECK(RGBWWDmxReceiver::parseArtNet(packet, length, frame));
+	CHECK_EQUAL(frame.protocol, RGBWW_DMX_PROTOCOL::RGBWW_DMX_ARTNET);
+	CHECK_EQUAL(frame.universe, 0x123);
+	CHECK_EQUAL(frame.length, 512);
+	CHECK(!RGBWWDmxReceiver::parseE131(packet, length, frame));
+}
+
+
+static void testLocalhost() {
+	RGBWWRecordingOutput out(16);
+	RGBWWLed led;
+	led.init(&out);
+	RGBWWDmxReceiver receiver(&led, 2, 10);
+	receiver.setRaw(true);
+
+	LocalSocket tx;
+	LocalSocket rx;
+	uint8_t slots[RGBWW_DMX_CHANNELS] = { 0 };
+	uint8_t packet[RGBWW_E131_PACKETSIZE];
+	uint8_t buffer[1500];
+
+	// E1.31 - channels 10 - 14
+	slots[9] = 255;
+	slots[10] = 128;
+	slots[11] = 1;
+	slots[13] = 64;
+	int length = makeE131(packet, 2, 1, slots, RGBWW_DMX_CHANNELS);
+	CHECK(tx.sendTo(packet, length, rx.port));
+	int received = rx.receive(buffer, sizeof(buffer));
+	CHECK_EQUAL(received, length);
+	CHECK(receiver.process(buffer, received));
+	CHECK_EQUAL(lastDuty(out, RGBWW_CHANNELS::RED), RGBWW_PWMMAXVAL);
+	CHECK_EQUAL(lastDuty(out, RGBWW_CHANNELS::GREEN), dmxDuty(128));
+	CHECK_EQUAL(lastDuty(out, RGBWW_CHANNELS::BLUE), dmxDuty(1));
+	CHECK_EQUAL(lastDuty(out, RGBWW_CHANNELS::WW), 0);
+	CHECK_EQUAL(lastDuty(out, RGBWW_CHANNELS::CW), dmxDuty(64));
+
+	// Art-Net - same universe, next sequence
+	slots[9] = 0;
+	length = makeArtNet(packet, 2, 2, slots, RGBWW_DMX_CHANNELS);
+	CHECK(tx.sendTo(packet, length, rx.port));
+	received = rx.receive(buffer, sizeof(buffer));
+	CHECK(receiver.process(buffer, received));
+	CHECK_EQUAL(lastDuty(out, RGBWW_CHANNELS::RED), 0);
+
+	// old sequence, other universe, preview data, too short, no dmx
+	length = makeE131(packet, 2, 1, slots, RGBWW_DMX_CHANNELS);
+	tx.sendTo(packet, length, rx.port);
+	length = makeE131(packet, 3, 3, slots, RGBWW_DMX_CHANNELS);
+	tx.sendTo(packet, length, rx.port);
+	length = makeE131(packet, 2, 4, slots, RGBWW_DMX_CHANNELS, 0x80);
+	tx.sendTo(packet, length, rx.port);
+	length = makeArtNet(packet, 2, 5, slots, 12);
+	tx.sendTo(packet, length, rx.port);
+	tx.sendTo((const uint8_t*)"hello", 5, rx.port);
+	for (int i = 0; i < 5; i++) {
+		received = rx.receive(buffer, sizeof(buffer));
+		CHECK(!receiver.process(buffer, received));
+	}
+
+	RGBWWDmxStats stats = receiver.getStats();
+	CHECK_EQUAL(stats.packets, 7);
+	CHECK_EQUAL(stats.frames, 2);
+	CHECK_EQUAL(stats.outoforder, 1);
+	CHECK_EQUAL(stats.ignored, 3);
+	CHECK_EQUAL(stats.invalid, 1);
+}
+
+
+static void testSenderPartial() {
+	LimitedTransport transport(2);
+	RGBWWE131Sender sender(&transport, 10, 5);
+
+	// all universes are changed after construction - two per send()
+	CHECK_EQUAL(sender.send(), 2);
+	CHECK_EQUAL(sender.send(), 2);
+	CHECK_EQUAL(sender.send(), 1);
+	CHECK_EQUAL(sender.send(), 0);
+	CHECK_EQUAL(sender.getPackets(), 5);
+	CHECK_EQUAL(transport.count, 5);
+	for (int i = 0; i < 5; i++) {
+		CHECK_EQUAL(transport.universes[i], 10 + i);
+	}
+
+	// nothing sent - the universe stays changed
+	transport.limit = 0;
+	sender.setChanged(12);
+	CHECK_EQUAL(sender.send(), 0);
+	transport.limit = 2;
+	CHECK_EQUAL(sender.send(), 1);
+	CHECK_EQUAL(transport.universes[5], 12);
+
+	// universes not handled by the sender
+	sender.setChanged(9);
+	sender.setChanged(15);
+	sender.setChanged(0xFFFF);
+	CHECK(sender.getSlots(15) == NULL);
+	CHECK_EQUAL(sender.send(), 0);
+}
+
+
+static void testSenderLocalhost() {
+	LocalSocket rx;
+	RGBWWLinuxUdp udp("127.0.0.1", rx.port);
+	RGBWWE131Sender sender(&udp, 4, 2);
+	uint8_t buffer[1500];
+
+	// two controllers in universe 5
+	RGBWWE131Output out1(&sender, 5, 1);
+	RGBWWE131Output out2(&sender, 5, 6);
+	RGBWWLed led1;
+	RGBWWLed led2;
+	led1.init(&out1);
+	led2.init(&out2);
+	int maxval = RGBWW_PWMMAXVAL;
+	int half = RGBWW_PWMMAXVAL / 2;
+	int zero = 0;
+	// half duty rounded to a dmx value and back
+	int halfDmx = dmxDuty((long(half) * 255 + RGBWW_PWMMAXVAL / 2) / RGBWW_PWMMAXVAL);
+	led1.setOutputRaw(maxval, zero, half, zero, zero);
+	led2.setOutputRaw(zero, maxval, zero, zero, half);
+
+	// first send() - both universes
+	CHECK_EQUAL(sender.send(), 2);
+	RGBWWRecordingOutput out(16);
+	RGBWWLed led;
+	led.init(&out);
+	RGBWWDmxReceiver receiver1(&led, 5, 1);
+	RGBWWDmxReceiver receiver2(&led, 5, 6);
+	receiver1.setRaw(true);
+	receiver2.setRaw(true);
+	for (int i = 0; i < 2; i++) {
+		int received = rx.receive(buffer, sizeof(buffer));
+		CHECK_EQUAL(received, RGBWW_E131_PACKETSIZE);
+		RGBWWDmxFrame frame;
+		CHECK(RGBWWDmxReceiver::parseE131(buffer, received, frame));
+		CHECK_EQUAL(frame.universe, 4 + i);
+		CHECK_EQUAL(frame.length, RGBWW_DMX_CHANNELS);
+		if (frame.universe == 5) {
+			CHECK(receiver1.process(buffer, received));
+			CHECK_EQUAL(lastDuty(out, RGBWW_CHANNELS::RED), RGBWW_PWMMAXVAL);
+			CHECK_EQUAL(lastDuty(out, RGBWW_CHANNELS::BLUE), halfDmx);
+			CHECK(receiver2.process(buffer, received));
+			CHECK_EQUAL(lastDuty(out, RGBWW_CHANNELS::GREEN), RGBWW_PWMMAXVAL);
+			CHECK_EQUAL(lastDuty(out, RGBWW_CHANNELS::CW), halfDmx);
+		}
+	}
+
+	// only the changed universe, with the next sequence number
+	CHECK_EQUAL(sender.send(), 0);
+	led2.setOutputRaw(zero, zero, zero, zero, zero);
+	CHECK_EQUAL(sender.send(), 1);
+	int received = rx.receive(buffer, sizeof(buffer));
+	CHECK(receiver2.process(buffer, received));
+	CHECK_EQUAL(lastDuty(out, RGBWW_CHANNELS::GREEN), 0);
+	CHECK_EQUAL(receiver2.getStats().outoforder, 0);
+}
+
+
+int main() {
+	testParse();
+	testLocalhost();
+	testSenderPartial();
+	testSenderLocalhost();
+	return checkResult();
+}
@@ -0,0 +1,223 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Frame interval histogram, late and missed frames of the animation
+ * player on a simulated clock (built with RGBWW_HOST_SIMCLOCK)
+ *
+ * The host has no interval gate (ARDUINO is not defined), every
+ * show() with a running animation is a frame and early stays 0.
+ * Built with RGBWW_FRAME_GATE only the gate of arduino is tested.
+ */
+
+#include "bench.h"
+#include "check.h"
+
+#include "RGBWWMultiLed.h"
+
+unsigned long hostMicros = 0;
+
+static const unsigned long target = RGBWW_MINTIMEDIFF * 1000UL;
+
+
+static int histogramBucket(unsigned long interval) {
+	unsigned long bucket = interval / (target / 4);
+	return (bucket < RGBWW_FRAMESTATS_BUCKETS) ? bucket : RGBWW_FRAMESTATS_BUCKETS - 1;
+}
+
+// start a long fade, the first frame is not timed
+static void startFade(RGBWWLed& led, int steps) {
+	ChannelOutput from(0, 0, 0, 0, 0);
+	ChannelOutput to(RGBWW_CALC_MAXVAL, 0, 0, 0, 0);
+	led.fadeRAW(from, to, steps * RGBWW_MINTIMEDIFF);
+	led.show();
+	led.resetFrameStats();
+}
+
+static void frame(RGBWWLed& led, unsigned long interval) {
+	hostMicros += interval;
+	led.show();
+}
+
+
+static void testIntervals() {
+	NullOutput out;
+	RGBWWLed led;
+	led.init(&out);
+	startFade(led, 1000);
+
+	// on time and within the tolerance
+	for (int i = 0; i < 10; i++) {
+		frame(led, target);
+	}
+	frame(led, target + RGBWW_FRAMESTATS_TOLERANCE);
+	RGBWWFrameStats stats = led.getFrameStats();
+	CHECK_EQUAL(stats.frames, 11);
+	CHECK_EQUAL(stats.late, 0);
+	CHECK_EQUAL(stats.missed, 0);
+	CHECK_EQUAL(stats.early, 0);
+	CHECK_EQUAL(stats.maxlateness, 0);
+	CHECK_EQUAL(stats.histogram[histogramBucket(target)], 10);
+	CHECK_EQUAL(stats.histogram[histogramBucket(target + RGBWW_FRAMESTATS_TOLERANCE)], 1);
+
+	// late, but no frame missed
+	frame(led, target + RGBWW_FRAMESTATS_TOLERANCE + 1);
+	stats = led.getFrameStats();
+	CHECK_EQUAL(stats.late, 1);
+	CHECK_EQUAL(stats.missed, 0);
+	CHECK_EQUAL(stats.maxlateness, RGBWW_FRAMESTATS_TOLERANCE + 1);
+
+	// three intervals - two frames missed, in the last bucket
+	frame(led, 3 * target + 100);
+	stats = led.getFrameStats();
+	CHECK_EQUAL(stats.late, 2);
+	CHECK_EQUAL(stats.missed, 2);
+	CHECK_EQUAL(stats.maxlateness, 2 * target + 100);
+	CHECK_EQUAL(stats.histogram[RGBWW_FRAMESTATS_BUCKETS - 1], 1);
+
+	// short intervals (show() called too often) are frames as well
+	frame(led, target / 4);
+	stats = led.getFrameStats();
+	CHECK_EQUAL(stats.frames, 14);
+	CHECK_EQUAL(stats.histogram[1], 1);
+	CHECK_EQUAL(stats.early, 0);
+
+	uint32_t sum = 0;
+	for (int i = 0; i < RGBWW_FRAMESTATS_BUCKETS; i++) {
+		sum += stats.histogram[i];
+	}
+	CHECK_EQUAL(sum, stats.frames);
+
+	led.resetFrameStats();
+	stats = led.getFrameStats();
+	CHECK_EQUAL(stats.frames, 0);
+	CHECK_EQUAL(stats.late, 0);
+	CHECK_EQUAL(stats.histogram[histogramBucket(target)], 0);
+}
+
+
+static void testIdle() {
+	NullOutput out;
+	RGBWWLed led;
+	led.init(&out);
+	startFade(led, 3);
+	frame(led, target);
+	frame(led, target);
+	// animation finished - idle for a second
+	for (int i = 0; i < 10; i++) {
+		frame(led, 100 * 1000UL);
+	}
+	CHECK(!led.isAnimationActive());
+	CHECK_EQUAL(led.getFrameStats().frames, 2);
+
+	// the first frame after the idle period is not timed
+	startFade(led, 10);
+	frame(led, target);
+	RGBWWFrameStats stats = led.getFrameStats();
+	CHECK_EQUAL(stats.frames, 1);
+	CHECK_EQUAL(stats.late, 0);
+}
+
+
+static void testSaturation() {
+	NullOutput out;
+	RGBWWLed led;
+	led.init(&out);
+	startFade(led, 0x10000 + 10);
+	for (long i = 0; i < 0x10000 + 5; i++) {
+		frame(led, target);
+	}
+	RGBWWFrameStats stats = led.getFrameStats();
+	CHECK_EQUAL(stats.frames, 0x10000 + 5);
+	CHECK_EQUAL(stats.histogram[histogramBucket(target)], 0xFFFF);
+}
+
+
+class NullMultiOutput: public RGBWWMultiOutput<8>
+{
+public:
+	void setDuties(const int* duty) {
+		sink = duty[0];
+	}
+};
+
+static void testMultiLed() {
+	NullMultiOutput out;
+	RGBWWMultiLed<8> led;
+	led.init(&out);
+	led.fadeRAW(RGBWWMultiLed<8>::Values(RGBWW_CALC_MAXVAL), 100 * RGBWW_MINTIMEDIFF);
+	led.show();
+	for (int i = 0; i < 5; i++) {
+		hostMicros += target;
+		led.show();
+	}
+	hostMicros += 2 * target + 100;
+	led.show();
+	RGBWWFrameStats stats = led.getFrameStats();
+	CHECK_EQUAL(stats.frames, 6);
+	CHECK_EQUAL(stats.late, 1);
+	CHECK_EQUAL(stats.missed, 1);
+}
+
+
+#ifdef RGBWW_FRAME_GATE
+// show() calls within RGBWW_MINTIMEDIFF are skipped
+static void testGate() {
+	NullOutput out;
+	RGBWWLed led;
+	led.init(&out);
+
+	// idle calls are not early
+	for (int i = 0; i < 10; i++) {
+		frame(led, target / 4);
+	}
+	RGBWWFrameStats stats = led.getFrameStats();
+	CHECK_EQUAL(stats.early, 0);
+	CHECK_EQUAL(stats.frames, 0);
+
+	hostMicros += target;
+	startFade(led, 100);
+	CHECK(led.isAnimationActive());
+	for (int i = 0; i < 3; i++) {
+		frame(led, target / 4);
+	}
+	stats = led.getFrameStats();
+	CHECK_EQUAL(stats.early, 3);
+	CHECK_EQUAL(stats.frames, 0);
+
+	// the interval passed - one frame of the full interval
+	frame(led, target / 4);
+	stats = led.getFrameStats();
+	CHECK_EQUAL(stats.early, 3);
+	CHECK_EQUAL(stats.frames, 1);
+	CHECK_EQUAL(stats.late, 0);
+	CHECK_EQUAL(stats.histogram[histogramBucket(target)], 1);
+
+	// queued animations are early as well
+	led.clearAnimationQueue();
+	led.skipAnimation();
+	hostMicros += target;
+	led.show();
+	led.resetFrameStats();
+	ChannelOutput color(0, RGBWW_CALC_MAXVAL, 0, 0, 0);
+	led.setRAW(color, 1000, true);
+	frame(led, target / 4);
+	CHECK_EQUAL(led.getFrameStats().early, 1);
+}
+#endif
+
+
+int main() {
+#ifdef RGBWW_FRAME_GATE
+	testGate();
+#else
+	testIntervals();
+	testIdle();
+	testSaturation();
+	testMultiLed();
+#endif
+	return checkResult();
+}
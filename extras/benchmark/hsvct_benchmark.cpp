@@ -0,0 +1,78 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * HSVCT construction and accessors - float against integer fixed point
+ *
+ * Hosts have a fpu, on the ESP8266 the float versions are soft float
+ * library calls and the difference is much larger.
+ * Also compares the rounding of both versions - the float version can
+ * be one step lower where (x / 360) * max lands just below an integer,
+ * larger differences are errors (exit code 1)
+ */
+
+#include "bench.h"
+
+#define BENCH_N 1000000L
+
+
+int main() {
+	// rounding over the whole domain (0.1 degree / 0.01 percent)
+	long mismatches = 0;
+	long errors = 0;
+	for (int i = 0; i <= 10000; i++) {
+		int hue = (i <= 3600) ? i : i % 3601;
+		HSVCT f(float(hue) / 10, float(i) / 100, float(10000 - i) / 100);
+		HSVCT x = HSVCT::fromFixed(hue, i, 10000 - i);
+		if (f.h != x.h || f.s != x.s || f.v != x.v) {
+			mismatches++;
+		}
+		if (x.h - f.h > 1 || x.s - f.s > 1 || x.v - f.v > 1 || x.h < f.h || x.s < f.s || x.v < f.v) {
+			errors++;
+		}
+	}
+
+	benchBegin("hsvct");
+	benchValue("rounding.mismatches", "value", mismatches);
+	benchValue("rounding.errors", "value", errors);
+
+	bench("hsvct.float", [&]() {
+		for (long i = 0; i < BENCH_N; i++) {
+			HSVCT c(float(i % 3600) / 10, float(i % 10000) / 100, 50.0f);
+			sink = c.h + c.s;
+		}
+		return BENCH_N;
+	});
+	bench("hsvct.fixed", [&]() {
+		for (long i = 0; i < BENCH_N; i++) {
+			HSVCT c = HSVCT::fromFixed(i % 3600, i % 10000, 5000);
+			sink = c.h + c.s;
+		}
+		return BENCH_N;
+	});
+
+	HSVCT color(RGBWW_CALC_HUEWHEELMAX / 3, RGBWW_CALC_MAXVAL / 2, RGBWW_CALC_MAXVAL);
+	bench("asradian", [&]() {
+		float hue, sat, val;
+		for (long i = 0; i < BENCH_N; i++) {
+			color.h = i % RGBWW_CALC_HUEWHEELMAX;
+			color.asRadian(hue, sat, val);
+			sink = int(hue + sat + val);
+		}
+		return BENCH_N;
+	});
+	bench("asfixed", [&]() {
+		int hue, sat, val;
+		for (long i = 0; i < BENCH_N; i++) {
+			color.h = i % RGBWW_CALC_HUEWHEELMAX;
+			color.asFixed(hue, sat, val);
+			sink = hue + sat + val;
+		}
+		return BENCH_N;
+	});
+	benchEnd();
+	return errors ? 1 : 0;
+}
@@ -0,0 +1,286 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Hue maps of the built in HSV models against the branch based
+ * conversions they replaced (copied below as reference)
+ *
+ * Every hue of the wheel is converted on a saturation / value grid,
+ * with the default hue wheel and with hue wheel corrections
+ *
+ *	RAW			equal
+ *	SPEKTRUM	the reference halves chroma (chroma >> 1), the map scales
+ *				chroma with the factor RGBWW_CALC_MAXVAL >> 1 - at most
+ *				MAXERROR_SPEKTRUM steps
+ *	RAINBOW		the reference places the colors at multiples of
+ *				RGBWW_CALC_HUEWHEELMAX / 8, the map on the hue wheel sectors.
+ *				Compared at the transformed hue (rounded) - at most
+ *				MAXERROR_RAINBOW steps
+ */
+
+#include "RGBWWLed.h"
+#include "check.h"
+#include <stdlib.h>
+
+#define GRID				16
+#define MAXERROR_SPEKTRUM	2
+#define MAXERROR_RAINBOW	1
+
+
+/**************************************************************
+ *                 reference
+ **************************************************************/
+
+struct HueWheel {
+	int sector[7];
+	int width[6];
+};
+
+static int parseColorCorrection(float val) {
+	if (val >= 30.0) val = 30.0;
+	if (val <= -30.0) val = -30.0;
+	return int(((val / 60) * (RGBWW_CALC_MAXVAL)) * -1);
+}
+
+static void createHueWheel(HueWheel& wheel, const float* correction) {
+	wheel.sector[0] = 0;
+	for (int i = 1; i <= 6; ++i) {
+		wheel.sector[i] = i*RGBWW_CALC_MAXVAL;
+		wheel.width[i-1] = RGBWW_CALC_MAXVAL;
+	}
+	// red, yellow, green, cyan, blue, magenta
+	for (int i = 0; i < 6; i++) {
+		wheel.width[i] -= parseColorCorrection(correction[i]);
+		wheel.width[i] += parseColorCorrection(correction[(i + 1) % 6]);
+		wheel.sector[i + 1] += parseColorCorrection(correction[(i + 1) % 6]);
+	}
+	wheel.sector[0] += parseColorCorrection(correction[0]);
+}
+
+static void refRaw(const HueWheel& wheel, int hue, int chroma, int* rgb) {
+	const int* sector = wheel.sector;
+	const int* width = wheel.width;
+	int fract;
+	if (hue < sector[0] || (hue > sector[5] && hue <= sector[6])) {
+		fract = (hue < sector[0]) ? RGBWW_CALC_MAXVAL + hue : hue - sector[5];
+		rgb[0] = chroma;
+		rgb[1] = 0;
+		rgb[2] = (chroma * (RGBWW_CALC_MAXVAL - (RGBWW_CALC_MAXVAL * fract) / width[5])) / RGBWW_CALC_MAXVAL;
+	} else if (hue <= sector[1] || hue > sector[6]) {
+		fract = (hue > sector[6]) ? hue - sector[6] : hue + (RGBWW_CALC_HUEWHEELMAX - sector[6]);
+		rgb[0] = chroma;
+		rgb[1] = (chroma * ((RGBWW_CALC_MAXVAL * fract) / width[0])) / RGBWW_CALC_MAXVAL;
+		rgb[2] = 0;
+	} else if (hue <= sector[2]) {
+		fract = hue - sector[1];
+		rgb[0] = (chroma * (RGBWW_CALC_MAXVAL - (RGBWW_CALC_MAXVAL * fract) / width[1])) / RGBWW_CALC_MAXVAL;
+		rgb[1] = chroma;
+		rgb[2] = 0;
+	} else if (hue <= sector[3]) {
+		fract = hue - sector[2];
+		rgb[0] = 0;
+		rgb[1] = chroma;
+		rgb[2] = (chroma * ((RGBWW_CALC_MAXVAL * fract) / width[2])) / RGBWW_CALC_MAXVAL;
+	} else if (hue <= sector[4]) {
+		fract = hue - sector[3];
+		rgb[0] = 0;
+		rgb[1] = (chroma * (RGBWW_CALC_MAXVAL - (RGBWW_CALC_MAXVAL * fract) / width[3])) / RGBWW_CALC_MAXVAL;
+		rgb[2] = chroma;
+	} else {
+		fract = hue - sector[4];
+		rgb[0] = (chroma * ((RGBWW_CALC_MAXVAL * fract) / width[4])) / RGBWW_CALC_MAXVAL;
+		rgb[1] = 0;
+		rgb[2] = chroma;
+	}
+}
+
+static void refSpektrum(const HueWheel& wheel, int hue, int chroma, int* rgb) {
+	const int* sector = wheel.sector;
+	const int* width = wheel.width;
+	int half_chroma = chroma >> 1;
+	int fract;
+	if (hue < sector[0] || (hue > sector[5] && hue <= sector[6])) {
+		fract = (hue < sector[0]) ? RGBWW_CALC_MAXVAL + hue : hue - sector[5];
+		fract = (half_chroma * ((RGBWW_CALC_MAXVAL * fract) / width[5])) / RGBWW_CALC_MAXVAL;
+		rgb[0] = half_chroma + fract;
+		rgb[1] = 0;
+		rgb[2] = half_chroma - fract;
+	} else if (hue <= sector[1] || hue > sector[6]) {
+		fract = (hue > sector[6]) ? hue - sector[6] : hue + (RGBWW_CALC_HUEWHEELMAX - sector[6]);
+		fract = (half_chroma * ((RGBWW_CALC_MAXVAL * fract) / width[0])) / RGBWW_CALC_MAXVAL;
+		rgb[0] = chroma - fract;
+		rgb[1] = fract;
+		rgb[2] = 0;
+	} else if (hue <= sector[2]) {
+		fract = hue - sector[1];
+		fract = (half_chroma * ((RGBWW_CALC_MAXVAL * fract) / width[1])) / RGBWW_CALC_MAXVAL;
+		rgb[0] = half_chroma - fract;
+		rgb[1] = half_chroma + fract;
+		rgb[2] = 0;
+	} else if (hue <= sector[3]) {
+		fract = hue - sector[2];
+		fract = (half_chroma * ((RGBWW_CALC_MAXVAL * fract) / width[2])) / RGBWW_CALC_MAXVAL;
+		rgb[0] = 0;
+		rgb[1] = chroma - fract;
+		rgb[2] = fract;
+	} else if (hue <= sector[4]) {
+		fract = hue - sector[3];
+		fract = (half_chroma * ((RGBWW_CALC_MAXVAL * fract) / width[3])) / RGBWW_CALC_MAXVAL;
+		rgb[0] = 0;
+		rgb[1] = half_chroma - fract;
+		rgb[2] = half_chroma + fract;
+	} else {
+		fract = hue - sector[4];
+		fract = (half_chroma * ((RGBWW_CALC_MAXVAL * fract) / width[4])) / RGBWW_CALC_MAXVAL;
+		rgb[0] = fract;
+		rgb[1] = 0;
+		rgb[2] = chroma - fract;
+	}
+}
+
+#define rainbow_third int(RGBWW_CALC_MAXVAL / 3)
+#define rainbow_two_third int(rainbow_third *2)
+#define rainbow_sector_width int (RGBWW_CALC_HUEWHEELMAX / 8)
+
+static void refRainbow(int hue, int chroma, int* rgb) {
+	int sector = hue / rainbow_sector_width;
+	int factor[3];
+	hue = hue - sector * rainbow_sector_width;
+	switch (sector) {
+	case 0:	// red -> orange
+		factor[0] = RGBWW_CALC_MAXVAL - (rainbow_third * hue) / rainbow_sector_width;
+		factor[1] = (rainbow_third * hue) / rainbow_sector_width;
+		factor[2] = 0;
+		break;
+	case 1:	// orange -> yellow
+		factor[0] = rainbow_two_third;
+		factor[1] = rainbow_third + (rainbow_third * hue) / rainbow_sector_width;
+		factor[2] = 0;
+		break;
+	case 2:	// yellow -> green
+		factor[0] = rainbow_two_third - (rainbow_two_third * hue) / rainbow_sector_width;
+		factor[1] = rainbow_two_third + (rainbow_third * hue) / rainbow_sector_width;
+		factor[2] = 0;
+		break;
+	case 3:	// green -> aqua
+		factor[0] = 0;
+		factor[1] = RGBWW_CALC_MAXVAL - (rainbow_third * hue) / rainbow_sector_width;
+		factor[2] = (rainbow_third * hue) / rainbow_sector_width;
+		break;
+	case 4:	// aqua -> blue
+		factor[0] = 0;
+		factor[1] = rainbow_two_third - (rainbow_two_third * hue) / rainbow_sector_width;
+		factor[2] = rainbow_third + (rainbow_two_third * hue) / rainbow_sector_width;
+		break;
+	case 5:	// blue -> purple
+		factor[0] = (rainbow_third * hue) / rainbow_sector_width;
+		factor[1] = 0;
+		factor[2] = RGBWW_CALC_MAXVAL - (rainbow_third * hue) / rainbow_sector_width;
+		break;
+	case 6:	// purple -> pink
+		factor[0] = rainbow_third + (rainbow_third * hue) / rainbow_sector_width;
+		factor[1] = 0;
+		factor[2] = rainbow_two_third - (rainbow_third * hue) / rainbow_sector_width;
+		break;
+	default:	// pink -> red
+		factor[0] = rainbow_two_third + (rainbow_third * hue) / rainbow_sector_width;
+		factor[1] = 0;
+		factor[2] = rainbow_third - (rainbow_third * hue) / rainbow_sector_width;
+		break;
+	}
+	for (int i = 0; i < 3; i++) {
+		rgb[i] = (chroma * factor[i]) / RGBWW_CALC_MAXVAL;
+	}
+}
+
+// hue of the reference rainbow for a hue of the (corrected) wheel
+static int rainbowHue(const HueWheel& wheel, int hue) {
+	const int* s = wheel.sector;
+	const int from[9] = { s[0], (s[0] + s[1]) / 2, s[1], s[2], s[3], s[4], s[5], (s[5] + s[6]) / 2, s[6] };
+	if (hue < from[0]) hue += RGBWW_CALC_HUEWHEELMAX;
+	if (hue >= from[8]) hue -= RGBWW_CALC_HUEWHEELMAX;
+	int i = 0;
+	while (hue >= from[i + 1]) {
+		i++;
+	}
+	long num = long(hue - from[i]) * rainbow_sector_width;
+	int den = from[i + 1] - from[i];
+	return i * rainbow_sector_width + int((2 * num + den) / (2 * den));
+}
+
+
+/**************************************************************
+ *                 comparison
+ **************************************************************/
+
+static int diff(const RGBWCT& rgbw, const int* rgb) {
+	int d = abs(rgbw.r - rgb[0]);
+	d = (abs(rgbw.g - rgb[1]) > d) ? abs(rgbw.g - rgb[1]) : d;
+	return (abs(rgbw.b - rgb[2]) > d) ? abs(rgbw.b - rgb[2]) : d;
+}
+
+static void compare(const float* correction) {
+	RGBWWColorUtils utils;
+	utils.setHSVcorrection(correction[0], correction[1], correction[2], correction[3], correction[4], correction[5]);
+	HueWheel wheel;
+	createHueWheel(wheel, correction);
+
+	long rawErrors = 0;
+	int maxSpektrum = 0;
+	int maxRainbow = 0;
+	const int step = (RGBWW_CALC_MAXVAL + GRID - 1) / GRID;
+	RGBWCT rgbw;
+	int rgb[3];
+	for (int s = 0; s <= RGBWW_CALC_MAXVAL + step - 1; s += step) {
+		for (int v = 0; v <= RGBWW_CALC_MAXVAL + step - 1; v += step) {
+			HSVCT hsv(0, (s > RGBWW_CALC_MAXVAL) ? RGBWW_CALC_MAXVAL : s, (v > RGBWW_CALC_MAXVAL) ? RGBWW_CALC_MAXVAL : v);
+			int chroma = (RGBWW_CALC_WIDE(hsv.s) * hsv.v) / RGBWW_CALC_MAXVAL;
+			for (int h = 0; h < RGBWW_CALC_HUEWHEELMAX; h++) {
+				hsv.h = h;
+				utils.HSVtoRGB(hsv, rgbw, RAW);
+				refRaw(wheel, h, (hsv.s == 0) ? 0 : chroma, rgb);
+				if (diff(rgbw, rgb) != 0) {
+					rawErrors++;
+				}
+				CHECK_EQUAL(rgbw.w, hsv.v - chroma);
+
+				utils.HSVtoRGB(hsv, rgbw, SPEKTRUM);
+				refSpektrum(wheel, h, (hsv.s == 0) ? 0 : chroma, rgb);
+				maxSpektrum = (diff(rgbw, rgb) > maxSpektrum) ? diff(rgbw, rgb) : maxSpektrum;
+
+				utils.HSVtoRGB(hsv, rgbw, RAINBOW);
+				refRainbow(rainbowHue(wheel, h), (hsv.s == 0) ? 0 : chroma, rgb);
+				maxRainbow = (diff(rgbw, rgb) > maxRainbow) ? diff(rgbw, rgb) : maxRainbow;
+			}
+		}
+	}
+	printf("correction %.0f %.0f %.0f %.0f %.0f %.0f: raw errors %ld, spektrum max error %d, rainbow max error %d\n",
+			correction[0], correction[1], correction[2], correction[3], correction[4], correction[5],
+			rawErrors, maxSpektrum, maxRainbow);
+	CHECK_EQUAL(rawErrors, 0);
+	CHECK(maxSpektrum <= MAXERROR_SPEKTRUM);
+	CHECK(maxRainbow <= MAXERROR_RAINBOW);
+}
+
+
+int main() {
+	// red, yellow, green, cyan, blue, magenta (degrees)
+	static const float corrections[][6] = {
+		{ 0, 0, 0, 0, 0, 0 },
+		{ 10, 0, 0, 0, 0, 0 },
+		{ -10, 0, 0, 0, 0, 0 },
+		{ 0, 5, -15, 20, -25, 0 },
+		{ 30, -30, 30, -30, 30, 0 },
+		{ -30, 30, -30, 30, -30, 0 }
+	};
+	for (const auto& correction : corrections) {
+		compare(correction);
+	}
+
+	// the maps are shared, not part of each configuration
+	CHECK(sizeof(RGBWWColorConfig) < sizeof(RGBWWHueMap));
+	return checkResult();
+}
@@ -0,0 +1,79 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Per frame cost of RGBWWMultiLed with 16 channels (i.e. a pwm expander)
+ * including the dim curve, power limiter and output stage
+ * (compare with transition.raw of benchmark.cpp for five channels)
+ */
+
+#include "bench.h"
+#include "RGBWWMultiLed.h"
+
+#define MULTI_CHANNELS 16
+
+class NullMultiOutput: public RGBWWMultiOutput<MULTI_CHANNELS>
+{
+public:
+	void setDuties(const int* duty) {
+		int sum = 0;
+		for (int i = 0; i < MULTI_CHANNELS; i++) {
+			sum += duty[i];
+		}
+		sink = sum;
+	}
+};
+
+typedef RGBWWMultiLed<MULTI_CHANNELS> MultiLed;
+
+// frames of a fade including the output pipeline of the controller
+static long runFade(MultiLed& led, const MultiLed::Values& from, const MultiLed::Values& to, int time) {
+	long ops = 0;
+	led.fadeRAW(from, to, time);
+	while (!led.show()) {
+		ops++;
+	}
+	return ops;
+}
+
+
+int main() {
+	NullMultiOutput out;
+	MultiLed led;
+	led.init(&out);
+
+	MultiLed::Values from(0);
+	MultiLed::Values to(0);
+	for (int i = 0; i < MULTI_CHANNELS; i++) {
+		from[i] = (i * RGBWW_CALC_MAXVAL) / (MULTI_CHANNELS - 1);
+		to[i] = RGBWW_CALC_MAXVAL - from[i];
+	}
+	const int time = 1000 * RGBWW_MINTIMEDIFF;
+
+	benchBegin("multi");
+	bench("multi16.fade", [&]() { return runFade(led, from, to, time); });
+
+	// every frame is scaled down
+	const int power[MULTI_CHANNELS] = { 100, 100, 100, 100, 100, 100, 100, 100,
+										100, 100, 100, 100, 100, 100, 100, 100 };
+	led.powerlimiter.setChannelPower(power);
+	led.powerlimiter.setBudget(400);
+	bench("multi16.fade.powerlimit", [&]() { return runFade(led, from, to, time); });
+	led.powerlimiter.setBudget(0);
+
+	bench("multi16.setoutput", [&]() {
+		MultiLed::Values v(0);
+		for (long n = 0; n < 100000; n++) {
+			for (int i = 0; i < MULTI_CHANNELS; i++) {
+				v[i] = (n + i) % (RGBWW_CALC_MAXVAL + 1);
+			}
+			led.setOutput(v);
+		}
+		return 100000L;
+	});
+	benchEnd();
+	return 0;
+}
@@ -0,0 +1,214 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Transactions of RGBWWPCA9685Output on a fake i2c bus
+ *
+ * Checks the init sequence (prescale), the split of changed channels
+ * into transactions (gap bridging, RGBWW_I2C_MAXWRITE), the FULL_ON /
+ * FULL_OFF bits and RGBWWPCA9685LedOutput driving RGBWWLed
+ */
+
+#include "RGBWWLed.h"
+#include "check.h"
+
+#define FAKE_MAXTRANSACTIONS 64
+
+struct I2CTransaction {
+	uint8_t	address;
+	uint8_t	data[RGBWW_I2C_MAXWRITE];
+	int		length;
+};
+
+class FakeI2CBus: public RGBWWI2CBus
+{
+public:
+	I2CTransaction	log[FAKE_MAXTRANSACTIONS];
+	int		count;
+	bool	fail;
+
+	FakeI2CBus() {
+		clear();
+		fail = false;
+	}
+
+	void clear() {
+		count = 0;
+	}
+
+	bool write(uint8_t address, const uint8_t* data, int length) {
+		if (count < FAKE_MAXTRANSACTIONS) {
+			log[count].address = address;
+			log[count].length = length;
+			memcpy(log[count].data, data, (length < RGBWW_I2C_MAXWRITE) ? length : RGBWW_I2C_MAXWRITE);
+		}
+		count++;
+		return !fail && length <= RGBWW_I2C_MAXWRITE;
+	}
+
+	// first channel written by a channel transaction
+	int firstChannel(int n) {
+		return (log[n].data[0] - 0x06) / 4;
+	}
+
+	// number of channels written by a channel transaction
+	int channels(int n) {
+		return (log[n].length - 1) / 4;
+	}
+
+	// LEDn_ON_L, LEDn_ON_H, LEDn_OFF_L, LEDn_OFF_H of a channel in a transaction
+	const uint8_t* channel(int n, int channel) {
+		return &log[n].data[1 + 4 * (channel - firstChannel(n))];
+	}
+};
+
+static int prescaleOf(int freq) {
+	FakeI2CBus bus;
+	RGBWWPCA9685Output chip(&bus);
+	chip.begin(freq);
+	// MODE1 (sleep), PRESCALE, ...
+	return (bus.count > 1 && bus.log[1].data[0] == 0xFE) ? bus.log[1].data[1] : -1;
+}
+
+
+static void testBegin() {
+	FakeI2CBus bus;
+	RGBWWPCA9685Output chip(&bus, 0x41);
+	CHECK(chip.begin(200));
+
+	// MODE1 sleep, PRESCALE, MODE2, MODE1 wake, MODE1 restart, 16 channels
+	CHECK_EQUAL(bus.count, 8);
+	for (int i = 0; i < bus.count; i++) {
+		CHECK_EQUAL(bus.log[i].address, 0x41);
+	}
+	CHECK_EQUAL(bus.log[0].data[0], 0x00);
+	CHECK_EQUAL(bus.log[0].data[1], 0x30);
+	CHECK_EQUAL(bus.log[1].data[0], 0xFE);
+	CHECK_EQUAL(bus.log[2].data[0], 0x01);
+	CHECK_EQUAL(bus.log[2].data[1], 0x04);
+	CHECK_EQUAL(bus.log[4].data[1], 0xA0);
+
+	// round(25MHz / (4096 * freq)) - 1, limited to [3, 255]
+	CHECK_EQUAL(prescaleOf(200), 30);
+	CHECK_EQUAL(prescaleOf(1000), 5);
+	CHECK_EQUAL(prescaleOf(24), 253);
+	CHECK_EQUAL(prescaleOf(1526), 3);
+	CHECK_EQUAL(prescaleOf(10000), 3);
+	CHECK_EQUAL(prescaleOf(1), 255);
+
+	// 16 channels split by RGBWW_I2C_MAXWRITE (7 channels per 32 byte write)
+	CHECK_EQUAL(bus.channels(5), 7);
+	CHECK_EQUAL(bus.channels(6), 7);
+	CHECK_EQUAL(bus.channels(7), 2);
+	CHECK_EQUAL(bus.log[5].length, 29);
+	CHECK_EQUAL(bus.firstChannel(5), 0);
+	CHECK_EQUAL(bus.firstChannel(6), 7);
+	CHECK_EQUAL(bus.firstChannel(7), 14);
+
+	// all channels FULL_OFF
+	CHECK_EQUAL(bus.channel(7, 15)[3], 0x10);
+}
+
+
+static void testTransactions() {
+	FakeI2CBus bus;
+	RGBWWPCA9685Output chip(&bus);
+	chip.begin();
+	bus.clear();
+
+	// unchanged - no transaction
+	int duty[RGBWW_PCA9685_CHANNELS] = { 0 };
+	chip.setDuties(duty);
+	CHECK_EQUAL(bus.count, 0);
+
+	// a gap of one channel is bridged
+	chip.setDuty(0, RGBWW_PWMMAXVAL / 2, false);
+	chip.setDuty(2, RGBWW_PWMMAXVAL / 2, false);
+	CHECK(chip.update());
+	CHECK_EQUAL(bus.count, 1);
+	CHECK_EQUAL(bus.firstChannel(0), 0);
+	CHECK_EQUAL(bus.channels(0), 3);
+
+	// a gap of two channels starts a new transaction
+	bus.clear();
+	chip.setDuty(5, RGBWW_PWMMAXVAL / 2, false);
+	chip.setDuty(8, RGBWW_PWMMAXVAL / 2, false);
+	chip.update();
+	CHECK_EQUAL(bus.count, 2);
+	CHECK_EQUAL(bus.firstChannel(0), 5);
+	CHECK_EQUAL(bus.channels(0), 1);
+	CHECK_EQUAL(bus.firstChannel(1), 8);
+
+	// FULL_ON, FULL_OFF and a partial duty (on at 0, off at the duty)
+	bus.clear();
+	chip.setDuty(10, RGBWW_PWMMAXVAL, false);
+	chip.setDuty(11, 0, false);
+	chip.setDuty(12, RGBWW_PWMMAXVAL / 4, false);
+	chip.setDuty(8, 0, false);
+	chip.update();
+	CHECK_EQUAL(chip.getDuty(10), RGBWW_PCA9685_MAXVAL);
+	CHECK_EQUAL(bus.count, 1);
+	CHECK_EQUAL(bus.firstChannel(0), 8);
+	CHECK_EQUAL(bus.channel(0, 8)[3], 0x10);
+	const uint8_t* full = bus.channel(0, 10);
+	CHECK_EQUAL(full[0], 0);
+	CHECK_EQUAL(full[1], 0x10);
+	CHECK_EQUAL(full[3] & 0x10, 0);
+	const uint8_t* part = bus.channel(0, 12);
+	int value = chip.getDuty(12);
+	CHECK(value > 0 && value < RGBWW_PCA9685_MAXVAL);
+	CHECK_EQUAL(part[0], 0);
+	CHECK_EQUAL(part[1], 0);
+	CHECK_EQUAL(part[2], value & 0xFF);
+	CHECK_EQUAL(part[3], value >> 8);
+
+	// failed writes stay pending
+	bus.clear();
+	bus.fail = true;
+	chip.setDuty(15, RGBWW_PWMMAXVAL, false);
+	CHECK(!chip.update());
+	bus.fail = false;
+	CHECK(chip.update());
+	CHECK_EQUAL(bus.count, 2);
+	CHECK_EQUAL(bus.firstChannel(1), 15);
+	CHECK(chip.update());
+	CHECK_EQUAL(bus.count, 2);
+
+	RGBWWPWMStats stats = chip.getStats();
+	CHECK(stats.skipped > 0);
+}
+
+
+static void testLedOutput() {
+	FakeI2CBus bus;
+	RGBWWPCA9685Output chip(&bus);
+	chip.begin();
+	bus.clear();
+
+	RGBWWPCA9685LedOutput out(&chip, 3, 4, 5, 6, 7);
+	RGBWWLed led;
+	led.init(&out);
+	led.setRAW(ChannelOutput(RGBWW_CALC_MAXVAL, 0, 0, 0, RGBWW_CALC_MAXVAL));
+	while (!led.show());
+
+	CHECK_EQUAL(chip.getDuty(3), RGBWW_PCA9685_MAXVAL);
+	CHECK_EQUAL(chip.getDuty(4), 0);
+	CHECK_EQUAL(chip.getDuty(7), RGBWW_PCA9685_MAXVAL);
+	CHECK_EQUAL(chip.getDuty(8), 0);
+	// only red and cold white changed - the gap is too large to bridge
+	CHECK_EQUAL(bus.count, 2);
+	CHECK_EQUAL(bus.firstChannel(0), 3);
+	CHECK_EQUAL(bus.channels(0), 1);
+	CHECK_EQUAL(bus.firstChannel(1), 7);
+}
+
+
+int main() {
+	testBegin();
+	testTransactions();
+	testLedOutput();
+	return checkResult();
+}
@@ -0,0 +1,133 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * RGBWWProfiler statistics and histogram buckets, and the stages
+ * recorded by the output pipeline (built with RGBWW_PROFILE)
+ */
+
+#include "bench.h"
+#include "check.h"
+
+
+static uint32_t histogramSum(const RGBWWProfileStats& stats) {
+	uint32_t sum = 0;
+	for (int i = 0; i < RGBWW_PROFILE_BUCKETS; i++) {
+		sum += stats.histogram[i];
+	}
+	return sum;
+}
+
+static void testRecord() {
+	RGBWWProfiler::reset();
+	const RGBWWProfileStats& stats = RGBWWProfiler::getStats(PROFILE_OUTPUT);
+	CHECK_EQUAL(stats.count, 0);
+	CHECK_EQUAL(stats.avg(), 0);
+
+	RGBWWProfiler::record(PROFILE_OUTPUT, 100);
+	RGBWWProfiler::record(PROFILE_OUTPUT, 300);
+	RGBWWProfiler::record(PROFILE_OUTPUT, 50);
+	CHECK_EQUAL(stats.count, 3);
+	CHECK_EQUAL(stats.min, 50);
+	CHECK_EQUAL(stats.max, 300);
+	CHECK_EQUAL(stats.total, 450);
+	CHECK_EQUAL(stats.avg(), 150);
+	// other stages are not touched
+	CHECK_EQUAL(RGBWWProfiler::getStats(PROFILE_FRAME).count, 0);
+
+	RGBWWProfiler::reset();
+	CHECK_EQUAL(stats.count, 0);
+	CHECK_EQUAL(stats.max, 0);
+	CHECK_EQUAL(histogramSum(stats), 0);
+}
+
+static void testBuckets() {
+	RGBWWProfiler::reset();
+	const RGBWWProfileStats& stats = RGBWWProfiler::getStats(PROFILE_FRAME);
+	const uint32_t first = 1UL << (RGBWW_PROFILE_MINBITS + 1);
+
+	// bucket 0 - everything below 2^(MINBITS + 1)
+	RGBWWProfiler::record(PROFILE_FRAME, 0);
+	RGBWWProfiler::record(PROFILE_FRAME, first - 1);
+	CHECK_EQUAL(stats.histogram[0], 2);
+	CHECK_EQUAL(RGBWWProfiler::getBucketMin(0), 0);
+
+	// buckets double in width
+	RGBWWProfiler::record(PROFILE_FRAME, first);
+	RGBWWProfiler::record(PROFILE_FRAME, 2 * first - 1);
+	RGBWWProfiler::record(PROFILE_FRAME, 2 * first);
+	CHECK_EQUAL(stats.histogram[1], 2);
+	CHECK_EQUAL(stats.histogram[2], 1);
+	CHECK_EQUAL(RGBWWProfiler::getBucketMin(1), first);
+	CHECK_EQUAL(RGBWWProfiler::getBucketMin(2), 2 * first);
+
+	// the last bucket holds everything above its lower bound
+	RGBWWProfiler::record(PROFILE_FRAME, 0xFFFFFFFF);
+	CHECK_EQUAL(stats.histogram[RGBWW_PROFILE_BUCKETS - 1], 1);
+	CHECK(RGBWWProfiler::getBucketMin(RGBWW_PROFILE_BUCKETS - 1) < 0xFFFFFFFF);
+	CHECK_EQUAL(histogramSum(stats), stats.count);
+
+	for (int i = 1; i < RGBWW_PROFILE_BUCKETS; i++) {
+		uint32_t min = RGBWWProfiler::getBucketMin(i);
+		RGBWWProfiler::reset();
+		RGBWWProfiler::record(PROFILE_FRAME, min);
+		RGBWWProfiler::record(PROFILE_FRAME, min - 1);
+		CHECK_EQUAL(stats.histogram[i], 1);
+		CHECK_EQUAL(stats.histogram[i - 1], 1);
+	}
+}
+
+static void testScope() {
+	RGBWWProfiler::reset();
+	{
+		RGBWW_PROFILE_SCOPE(PROFILE_ANIMATION);
+		sink = 1;
+	}
+	CHECK_EQUAL(RGBWWProfiler::getStats(PROFILE_ANIMATION).count, 1);
+	CHECK(RGBWWProfiler::getName(PROFILE_ANIMATION) != NULL);
+	CHECK_EQUAL(strcmp(RGBWWProfiler::getName(PROFILE_OUTPUT), "output"), 0);
+}
+
+static void testPipeline() {
+	NullOutput out;
+	RGBWWLed led;
+	led.init(&out);
+	const int steps = 50;
+	HSVCT color(RGBWW_CALC_HUEWHEELMAX / 3, RGBWW_CALC_MAXVAL, RGBWW_CALC_MAXVAL);
+
+	RGBWWProfiler::reset();
+	led.fadeHSV(color, steps * RGBWW_MINTIMEDIFF);
+	uint32_t frames = 0;
+	while (!led.show()) {
+		frames++;
+	}
+	CHECK(frames > 0);
+
+	// one pass of the pipeline per frame
+	CHECK_EQUAL(RGBWWProfiler::getStats(PROFILE_FRAME).count, frames);
+	CHECK_EQUAL(RGBWWProfiler::getStats(PROFILE_HSVTORGB).count, frames);
+	CHECK_EQUAL(RGBWWProfiler::getStats(PROFILE_WHITEBALANCE).count, frames);
+	CHECK_EQUAL(RGBWWProfiler::getStats(PROFILE_BRIGHTNESS).count, frames);
+	CHECK_EQUAL(RGBWWProfiler::getStats(PROFILE_DIMCURVE).count, frames);
+	CHECK_EQUAL(RGBWWProfiler::getStats(PROFILE_OUTPUT).count, frames);
+	// no stepping after the last frame
+	CHECK_EQUAL(RGBWWProfiler::getStats(PROFILE_ANIMATION).count, frames - 1);
+
+	// the frame contains all other stages
+	const RGBWWProfileStats& frame = RGBWWProfiler::getStats(PROFILE_FRAME);
+	CHECK(frame.min <= frame.avg() && frame.avg() <= frame.max);
+	CHECK(frame.total >= RGBWWProfiler::getStats(PROFILE_OUTPUT).total);
+	CHECK_EQUAL(histogramSum(frame), frame.count);
+}
+
+
+int main() {
+	testRecord();
+	testBuckets();
+	testScope();
+	testPipeline();
+	return checkResult();
+}
@@ -0,0 +1,36 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Stub of the espressif sdk pwm for host builds of the sming backend
+ * (RGBWW_USE_ESP_HWPWM). The calls are counted, see pwm_test.cpp
+ */
+
+#ifndef RGBWW_HOST_PWM_H
+#define RGBWW_HOST_PWM_H
+
+#include <stdint.h>
+
+#define PWM_CHANNEL_NUM_MAX 8
+
+struct PWMStubCalls {
+	uint32_t	init;
+	uint32_t	setPeriod;
+	uint32_t	setDuty;
+	uint32_t	start;
+	uint32_t	period;
+	uint32_t	duty[PWM_CHANNEL_NUM_MAX];
+};
+
+extern PWMStubCalls pwmStub;
+
+void pwm_init(uint32_t period, uint32_t* duty, uint32_t pwm_channel_num, uint32_t (*pin_info_list)[3]);
+void pwm_set_period(uint32_t period);
+void pwm_set_duty(uint32_t duty, uint8_t channel);
+uint32_t pwm_get_duty(uint8_t channel);
+void pwm_start(void);
+
+#endif //RGBWW_HOST_PWM_H
@@ -0,0 +1,129 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Calls of the sming pwm backend into the sdk pwm (stubbed in pwm.h)
+ *
+ * pwm_start() recalculates the phase table of the sdk pwm, it has
+ * to be called once per changed frame and never for unchanged duties
+ */
+
+#include "RGBWWLed.h"
+#include "check.h"
+
+PWMStubCalls pwmStub;
+EspDigitalPin EspDigitalPins[16];
+
+void pwm_init(uint32_t period, uint32_t* duty, uint32_t pwm_channel_num, uint32_t (*pin_info_list)[3]) {
+	pwmStub.init++;
+	pwmStub.period = period;
+	for (uint32_t i = 0; i < pwm_channel_num && i < PWM_CHANNEL_NUM_MAX; i++) {
+		pwmStub.duty[i] = duty[i];
+	}
+}
+
+void pwm_set_period(uint32_t period) {
+	pwmStub.setPeriod++;
+	pwmStub.period = period;
+}
+
+void pwm_set_duty(uint32_t duty, uint8_t channel) {
+	pwmStub.setDuty++;
+	pwmStub.duty[channel] = duty;
+}
+
+uint32_t pwm_get_duty(uint8_t channel) {
+	return pwmStub.duty[channel];
+}
+
+void pwm_start(void) {
+	pwmStub.start++;
+}
+
+
+static void testOutput() {
+	memset(&pwmStub, 0, sizeof(pwmStub));
+	PWMOutput pwm(0, 1, 2, 3, 4, 200);
+	CHECK_EQUAL(pwmStub.init, 1);
+	CHECK_EQUAL(pwmStub.start, 1);
+	CHECK_EQUAL(pwmStub.period, 5000);
+
+	// unchanged duties - no calls
+	pwm.setOutput(0, 0, 0, 0, 0);
+	CHECK_EQUAL(pwmStub.setDuty, 0);
+	CHECK_EQUAL(pwmStub.start, 1);
+
+	// one channel changed - one duty, one start
+	pwm.setOutput(100, 0, 0, 0, 0);
+	CHECK_EQUAL(pwmStub.setDuty, 1);
+	CHECK_EQUAL(pwmStub.start, 2);
+	CHECK_EQUAL(pwmStub.duty[RGBWW_CHANNELS::RED], 100);
+
+	// all channels changed - still one start
+	pwm.setOutput(1, 2, 3, 4, 5);
+	CHECK_EQUAL(pwmStub.setDuty, 6);
+	CHECK_EQUAL(pwmStub.start, 3);
+
+	// single channel setters
+	pwm.setGreen(2);
+	CHECK_EQUAL(pwmStub.start, 3);
+	pwm.setGreen(20);
+	CHECK_EQUAL(pwmStub.start, 4);
+	CHECK_EQUAL(pwm.getGreen(), 20);
+
+	// deferred update starts once
+	const int duty[RGBWW_CHANNELS::NUM_CHANNELS] = { 10, 20, 30, 40, 50 };
+	pwm.setDuties(duty, false);
+	pwm.setColdWhite(60, false);
+	CHECK_EQUAL(pwmStub.start, 4);
+	pwm.update();
+	pwm.update();
+	CHECK_EQUAL(pwmStub.start, 5);
+	CHECK_EQUAL(pwmStub.duty[RGBWW_CHANNELS::CW], 60);
+
+	RGBWWPWMStats stats = pwm.getStats();
+	CHECK_EQUAL(stats.updates, 4);
+	CHECK_EQUAL(stats.writes, pwmStub.setDuty);
+
+	pwm.setFrequency(1000);
+	CHECK_EQUAL(pwmStub.period, 1000);
+}
+
+
+static void testController() {
+	memset(&pwmStub, 0, sizeof(pwmStub));
+	RGBWWLed led;
+	led.init(0, 1, 2, 3, 4);
+
+	// steady color - a single start for the first frame
+	ChannelOutput color(RGBWW_CALC_MAXVAL, 0, RGBWW_CALC_MAXVAL / 2, 0, 0);
+	led.setRAW(color);
+	while (!led.show());
+	uint32_t start = pwmStub.start;
+	for (int i = 0; i < 100; i++) {
+		led.setRAW(color);
+		while (!led.show());
+		led.show();
+	}
+	CHECK_EQUAL(pwmStub.start, start);
+
+	// fade - at most one start per frame
+	int frames = 0;
+	led.setRAW(ChannelOutput(0, RGBWW_CALC_MAXVAL, 0, 0, 0), 100 * RGBWW_MINTIMEDIFF);
+	start = pwmStub.start;
+	while (!led.show()) {
+		frames++;
+	}
+	CHECK(pwmStub.start - start > 0);
+	CHECK(pwmStub.start - start <= uint32_t(frames + 1));
+}
+
+
+int main() {
+	testOutput();
+	testController();
+	return checkResult();
+}
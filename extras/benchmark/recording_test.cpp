@@ -0,0 +1,136 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Ring buffer of RGBWWRecordingOutput - wrap around, overflows,
+ * pop, clear and the index range of getFrame
+ * (built with RGBWW_HOST_SIMCLOCK for the timestamps)
+ */
+
+#include "check.h"
+
+#include "RGBWWLed.h"
+
+unsigned long hostMicros = 0;
+
+
+// frame n - all channels n, recorded at n us
+static void record(RGBWWRecordingOutput& out, int n) {
+	hostMicros = n;
+	out.setOutput(n, n, n, n, n);
+}
+
+static bool isFrame(const RGBWWOutputFrame& frame, int n) {
+	for (int i = 0; i < RGBWW_CHANNELS::NUM_CHANNELS; i++) {
+		if (frame.duty[i] != n) {
+			return false;
+		}
+	}
+	return frame.time == uint32_t(n);
+}
+
+
+static void testWrap() {
+	RGBWWRecordingOutput out(4);
+	RGBWWOutputFrame frame;
+	CHECK_EQUAL(out.getCount(), 0);
+	CHECK(!out.getFrame(0, frame));
+	CHECK(!out.pop(frame));
+
+	for (int n = 1; n <= 3; n++) {
+		record(out, n);
+	}
+	CHECK_EQUAL(out.getCount(), 3);
+	CHECK(out.getFrame(0, frame) && isFrame(frame, 1));
+	CHECK(out.getFrame(2, frame) && isFrame(frame, 3));
+	CHECK(!out.getFrame(3, frame));
+	CHECK(!out.getFrame(-1, frame));
+
+	// the front moves - new frames wrap around the end of the buffer
+	CHECK(out.pop(frame) && isFrame(frame, 1));
+	CHECK(out.pop(frame) && isFrame(frame, 2));
+	for (int n = 4; n <= 6; n++) {
+		record(out, n);
+	}
+	CHECK_EQUAL(out.getCount(), 4);
+	CHECK_EQUAL(out.getOverflows(), 0);
+	for (int i = 0; i < 4; i++) {
+		CHECK(out.getFrame(i, frame) && isFrame(frame, 3 + i));
+	}
+	// stale frames beyond the count are not returned
+	CHECK(!out.getFrame(4, frame));
+	CHECK(!out.getFrame(7, frame));
+	CHECK_EQUAL(out.getFrames(), 6);
+}
+
+
+static void testOverflow() {
+	RGBWWRecordingOutput out(4);
+	RGBWWOutputFrame frame;
+	for (int n = 1; n <= 10; n++) {
+		record(out, n);
+	}
+	// the oldest frames are dropped
+	CHECK_EQUAL(out.getCount(), 4);
+	CHECK_EQUAL(out.getFrames(), 10);
+	CHECK_EQUAL(out.getOverflows(), 6);
+	for (int n = 7; n <= 10; n++) {
+		CHECK(out.pop(frame) && isFrame(frame, n));
+	}
+	CHECK(!out.pop(frame));
+	CHECK_EQUAL(out.getCount(), 0);
+	CHECK_EQUAL(out.getOverflows(), 6);
+
+	record(out, 11);
+	CHECK(out.getFrame(0, frame) && isFrame(frame, 11));
+	CHECK_EQUAL(out.getOverflows(), 6);
+}
+
+
+static void testClear() {
+	RGBWWRecordingOutput out(4);
+	RGBWWOutputFrame frame;
+	for (int n = 1; n <= 6; n++) {
+		record(out, n);
+	}
+	out.pop(frame);
+	out.clear();
+	CHECK_EQUAL(out.getCount(), 0);
+	CHECK_EQUAL(out.getFrames(), 0);
+	CHECK_EQUAL(out.getOverflows(), 0);
+	CHECK(!out.getFrame(0, frame));
+	CHECK(!out.pop(frame));
+
+	record(out, 20);
+	CHECK_EQUAL(out.getCount(), 1);
+	CHECK(out.getFrame(0, frame) && isFrame(frame, 20));
+}
+
+
+// one frame per show() of a controller
+static void testController() {
+	RGBWWRecordingOutput out(8);
+	RGBWWLed led;
+	led.init(&out);
+	out.clear();
+	int maxval = RGBWW_PWMMAXVAL;
+	int zero = 0;
+	led.setOutputRaw(maxval, zero, zero, zero, zero);
+	RGBWWOutputFrame frame;
+	CHECK_EQUAL(out.getCount(), 1);
+	CHECK(out.pop(frame));
+	CHECK_EQUAL(frame.duty[RGBWW_CHANNELS::RED], RGBWW_PWMMAXVAL);
+	CHECK_EQUAL(frame.duty[RGBWW_CHANNELS::GREEN], 0);
+}
+
+
+int main() {
+	testWrap();
+	testOverflow();
+	testClear();
+	testController();
+	return checkResult();
+}
@@ -0,0 +1,77 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Decode throughput of RGBWWSequence - ns per frame and MB/s of
+ * sequence data for 5 and 64 channels at 8 and 16 bit depth
+ *
+ * The channels fade with different speeds, so the frames mix skip,
+ * delta and value runs
+ */
+
+#include "bench.h"
+#include "sequence_encode.h"
+#include <math.h>
+
+#define BENCH_FRAMES 2000
+
+
+static SequenceData makeSequence(int depth, int channels) {
+	const int maxval = (1 << depth) - 1;
+	SequenceData data;
+	sequenceHeader(data, depth, channels, 50, BENCH_FRAMES);
+	std::vector<int> previous(channels, 0);
+	std::vector<int> frame(channels, 0);
+	for (int n = 0; n < BENCH_FRAMES; n++) {
+		for (int i = 0; i < channels; i++) {
+			// every 4th channel holds its value for 8 frames
+			int t = (i % 4 == 3) ? n & ~7 : n;
+			double phase = t * (0.01 + 0.005 * (i % 7));
+			frame[i] = int(maxval * (0.5 + 0.5 * sin(phase)));
+		}
+		sequenceFrame(data, previous, frame);
+		previous = frame;
+	}
+	return data;
+}
+
+static void benchDecode(int depth, int channels) {
+	SequenceData data = makeSequence(depth, channels);
+	RGBWWSequence sequence;
+	sequence.open(data.data(), data.size());
+	long decoded = 0;
+
+	char name[64];
+	snprintf(name, sizeof(name), "sequence.decode.%dbit.%dch", depth, channels);
+	double ns = bench(name, [&]() {
+		sequence.rewind();
+		long frames = 0;
+		while (sequence.nextFrame()) {
+			sink = sequence.getRawValue(0);
+			frames++;
+		}
+		decoded = frames;
+		return frames;
+	});
+	snprintf(name, sizeof(name), "sequence.decode.%dbit.%dch.mbps", depth, channels);
+	benchValue(name, "mb_per_s", (double(data.size() - RGBWW_SEQUENCE_HEADERSIZE) / decoded) / ns * 1000);
+	snprintf(name, sizeof(name), "sequence.decode.%dbit.%dch.bytes_per_frame", depth, channels);
+	benchValue(name, "value", double(data.size() - RGBWW_SEQUENCE_HEADERSIZE) / decoded);
+	if (decoded != BENCH_FRAMES) {
+		fprintf(stderr, "%s: decoded %ld of %d frames\n", name, decoded, BENCH_FRAMES);
+	}
+}
+
+
+int main() {
+	benchBegin("sequence");
+	benchDecode(8, 5);
+	benchDecode(16, 5);
+	benchDecode(8, 64);
+	benchDecode(16, 64);
+	benchEnd();
+	return 0;
+}
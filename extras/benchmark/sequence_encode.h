@@ -0,0 +1,61 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Sequence encoder of the host tests and benchmarks - same encoding
+ * as extras/sequence_encoder.py (without merging single skips into
+ * delta runs)
+ */
+
+#ifndef RGBWW_SEQUENCE_ENCODE_H
+#define RGBWW_SEQUENCE_ENCODE_H
+
+#include "RGBWWLedSequence.h"
+#include <vector>
+
+typedef std::vector<uint8_t> SequenceData;
+
+static inline void sequenceHeader(SequenceData& out, int depth, int channels, int fps, uint32_t frames) {
+	const uint8_t header[RGBWW_SEQUENCE_HEADERSIZE] = {
+		'R', 'W', 'S', 'Q', RGBWW_SEQUENCE_VERSION, uint8_t(depth),
+		uint8_t(channels), uint8_t(channels >> 8), uint8_t(fps), uint8_t(fps >> 8), 0, 0,
+		uint8_t(frames), uint8_t(frames >> 8), uint8_t(frames >> 16), uint8_t(frames >> 24)
+	};
+	out.insert(out.end(), header, header + RGBWW_SEQUENCE_HEADERSIZE);
+}
+
+static inline int sequenceRunType(int previous, int value) {
+	int delta = value - previous;
+	if (delta == 0) {
+		return RGBWW_SEQUENCE_SKIP;
+	}
+	return (delta >= -128 && delta <= 127) ? RGBWW_SEQUENCE_DELTA : RGBWW_SEQUENCE_VALUE;
+}
+
+static inline void sequenceFrame(SequenceData& out, const std::vector<int>& previous, const std::vector<int>& frame) {
+	int channels = frame.size();
+	int channel = 0;
+	while (channel < channels) {
+		int type = sequenceRunType(previous[channel], frame[channel]);
+		int count = 1;
+		while (channel + count < channels && count < RGBWW_SEQUENCE_MAXRUN &&
+				sequenceRunType(previous[channel + count], frame[channel + count]) == type) {
+			count++;
+		}
+		out.push_back(type | (count - 1));
+		for (int i = channel; i < channel + count; i++) {
+			if (type == RGBWW_SEQUENCE_DELTA) {
+				out.push_back(uint8_t(frame[i] - previous[i]));
+			} else if (type == RGBWW_SEQUENCE_VALUE) {
+				out.push_back(frame[i] & 0xFF);
+				out.push_back(frame[i] >> 8);
+			}
+		}
+		channel += count;
+	}
+}
+
+#endif //RGBWW_SEQUENCE_ENCODE_H
@@ -0,0 +1,95 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * RGBWWSequence decoding and the rejection of values outside
+ * of the depth of the sequence
+ */
+
+#include "sequence_encode.h"
+#include "check.h"
+
+
+static void testDecode() {
+	SequenceData data;
+	sequenceHeader(data, 8, 3, 50, 3);
+	std::vector<int> zero(3, 0);
+	std::vector<int> first = { 255, 10, 0 };
+	std::vector<int> second = { 200, 10, 100 };
+	std::vector<int> third = { 0, 138, 100 };
+	sequenceFrame(data, zero, first);
+	sequenceFrame(data, first, second);
+	sequenceFrame(data, second, third);
+
+	RGBWWSequence sequence;
+	CHECK(sequence.open(data.data(), data.size()));
+	CHECK_EQUAL(sequence.getChannels(), 3);
+	CHECK_EQUAL(sequence.getFrames(), 3);
+	CHECK(sequence.nextFrame());
+	CHECK_EQUAL(sequence.getRawValue(0), 255);
+	CHECK_EQUAL(sequence.getValue(0), RGBWW_CALC_MAXVAL);
+	CHECK(sequence.nextFrame());
+	CHECK_EQUAL(sequence.getRawValue(0), 200);
+	CHECK_EQUAL(sequence.getRawValue(2), 100);
+	CHECK(sequence.nextFrame());
+	CHECK_EQUAL(sequence.getRawValue(0), 0);
+	CHECK_EQUAL(sequence.getRawValue(1), 138);
+	CHECK(!sequence.nextFrame());
+	CHECK_EQUAL(sequence.getValue(5), 0);
+}
+
+
+// single channel frame with one run
+static bool decodeRun(int depth, uint8_t type, const uint8_t* payload, int length, int& value) {
+	SequenceData data;
+	sequenceHeader(data, depth, 1, 50, 2);
+	// first frame - half of the range
+	int half = 1 << (depth - 1);
+	data.push_back(RGBWW_SEQUENCE_VALUE);
+	data.push_back(half & 0xFF);
+	data.push_back(half >> 8);
+	data.push_back(type);
+	data.insert(data.end(), payload, payload + length);
+
+	RGBWWSequence sequence;
+	sequence.open(data.data(), data.size());
+	sequence.nextFrame();
+	bool result = sequence.nextFrame();
+	value = sequence.getValue(0);
+	return result;
+}
+
+static void testRange() {
+	int value;
+	// 8bit - values above 255 are corrupt
+	const uint8_t value255[2] = { 255, 0 };
+	const uint8_t value256[2] = { 0, 1 };
+	const uint8_t valueMax[2] = { 0xFF, 0xFF };
+	CHECK(decodeRun(8, RGBWW_SEQUENCE_VALUE, value255, 2, value));
+	CHECK_EQUAL(value, RGBWW_CALC_MAXVAL);
+	CHECK(!decodeRun(8, RGBWW_SEQUENCE_VALUE, value256, 2, value));
+	CHECK(!decodeRun(8, RGBWW_SEQUENCE_VALUE, valueMax, 2, value));
+	CHECK(value >= 0 && value <= RGBWW_CALC_MAXVAL);
+	CHECK(decodeRun(16, RGBWW_SEQUENCE_VALUE, valueMax, 2, value));
+	CHECK_EQUAL(value, RGBWW_CALC_MAXVAL);
+
+	// deltas leaving the range (128 + 127 = 255 is the last valid value)
+	const uint8_t up[1] = { 127 };
+	const uint8_t down[1] = { uint8_t(-128) };
+	CHECK(decodeRun(8, RGBWW_SEQUENCE_DELTA, up, 1, value));
+	CHECK(decodeRun(8, RGBWW_SEQUENCE_DELTA, down, 1, value));
+	CHECK_EQUAL(value, 0);
+	CHECK(!decodeRun(7, RGBWW_SEQUENCE_DELTA, up, 1, value));
+	CHECK(!decodeRun(6, RGBWW_SEQUENCE_DELTA, down, 1, value));
+	CHECK(value >= 0 && value <= RGBWW_CALC_MAXVAL);
+}
+
+
+int main() {
+	testDecode();
+	testRange();
+	return checkResult();
+}
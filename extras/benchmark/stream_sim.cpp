@@ -0,0 +1,129 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Buffer underruns of RGBWWFrameStream with a jittery source
+ *
+ * Frames are sent at the update frequency and arrive in order after
+ * a random delay of up to JITTER ms, every STALL_EVERY frames the
+ * network stalls for STALL ms (frames arrive as a burst afterwards).
+ * fill() is called every ms (idle time of the main loop), pop() once
+ * per frame (RGBWW_MINTIMEDIFF) on a simulated clock. Frames are never
+ * dropped - each underrun delays the rest of the playback by a frame,
+ * so later stalls are partly absorbed. For each read ahead size:
+ *
+ *	underruns	frames the output was held
+ *	minfill		lowest number of buffered frames while playing
+ *	latency		ms from the first sent frame to the first played one
+ *
+ * A read ahead covering STALL + JITTER has to play without underruns
+ * (exit code 1 otherwise)
+ */
+
+#include "bench.h"
+
+#define FRAMES		3000
+#define JITTER		30
+#define STALL		100
+#define STALL_EVERY	500
+
+
+static unsigned long simTime;
+
+/**
+ * Frames becoming available at precalculated arrival times
+ */
+class JitterSource: public RGBWWFrameSource
+{
+public:
+	JitterSource() {
+		// deterministic lcg - same schedule for every read ahead
+		uint32_t seed = 12345;
+		unsigned long last = 0;
+		for (int i = 0; i < FRAMES; i++) {
+			seed = seed * 1103515245 + 12345;
+			unsigned long sent = (unsigned long)i * RGBWW_MINTIMEDIFF;
+			unsigned long arrival = sent + (seed >> 16) % (JITTER + 1);
+			if (i % STALL_EVERY == STALL_EVERY / 2) {
+				arrival += STALL;
+			}
+			// in order delivery - frames wait for the ones before
+			last = (arrival > last) ? arrival : last;
+			_arrival[i] = last;
+		}
+		_next = 0;
+	}
+
+	RGBWW_STREAM_STATE nextFrame(ChannelOutput& frame) {
+		if (_next >= FRAMES) {
+			return RGBWW_STREAM_STATE::STREAM_END;
+		}
+		if (_arrival[_next] > simTime) {
+			return RGBWW_STREAM_STATE::STREAM_WAIT;
+		}
+		frame = ChannelOutput(_next % (RGBWW_CALC_MAXVAL + 1), 0, 0, 0, 0);
+		_next++;
+		return RGBWW_STREAM_STATE::STREAM_FRAME;
+	}
+
+private:
+	unsigned long _arrival[FRAMES];
+	int		_next;
+};
+
+
+static bool simulate(int readahead) {
+	JitterSource source;
+	RGBWWFrameStream stream(&source, readahead);
+	long latency = -1;
+	int expected = 0;
+	bool ordered = true;
+	simTime = 0;
+	while (true) {
+		stream.fill();
+		if (simTime % RGBWW_MINTIMEDIFF == 0) {
+			ChannelOutput frame;
+			RGBWW_STREAM_STATE state = stream.pop(frame);
+			if (state == RGBWW_STREAM_STATE::STREAM_END) {
+				break;
+			}
+			if (state == RGBWW_STREAM_STATE::STREAM_FRAME) {
+				if (latency < 0) {
+					latency = simTime;
+				}
+				ordered = ordered && frame.r == expected % (RGBWW_CALC_MAXVAL + 1);
+				expected++;
+			}
+		}
+		simTime++;
+	}
+
+	RGBWWStreamStats stats = stream.getStats();
+	char name[64];
+	snprintf(name, sizeof(name), "stream.readahead%d.underruns", readahead);
+	benchValue(name, "value", stats.underruns);
+	snprintf(name, sizeof(name), "stream.readahead%d.minfill", readahead);
+	benchValue(name, "value", stats.minfill);
+	snprintf(name, sizeof(name), "stream.readahead%d.latency", readahead);
+	benchValue(name, "ms", latency);
+
+	bool covered = (readahead - 1) * RGBWW_MINTIMEDIFF >= STALL + JITTER;
+	return ordered && stats.frames == FRAMES && (!covered || stats.underruns == 0);
+}
+
+
+int main() {
+	int errors = 0;
+	benchBegin("stream");
+	const int sizes[] = { 1, 2, 4, RGBWW_STREAM_READAHEAD, 16 };
+	for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		if (!simulate(sizes[i])) {
+			errors++;
+		}
+	}
+	benchEnd();
+	return errors ? 1 : 0;
+}
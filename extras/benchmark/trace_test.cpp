@@ -0,0 +1,108 @@
+/**
+ * RGBWWLed - simple Library for controlling RGB WarmWhite ColdWhite LEDs via PWM
+ * @file
+ * @author  Patrick Jahns http://github.com/patrickjahns
+ *
+ * All files of this project are provided under the LGPL v3 license.
+ *
+ * Reading the trace ring (built with RGBWW_TRACE) - incremental reads,
+ * overwritten records and a clear() between two reads
+ */
+
+#include "RGBWWLed.h"
+#include "check.h"
+
+
+// number of the first record after clear() - numbers continue across clears
+static uint32_t clearTrace() {
+	RGBWWTrace::clear();
+	RGBWWTraceRecord record;
+	uint32_t next = 0;
+	RGBWWTrace::read(&record, 1, next);
+	return next;
+}
+
+static void testRead() {
+	uint32_t first = clearTrace();
+	RGBWWTraceRecord records[RGBWW_TRACE_SIZE];
+	uint32_t next = 0;
+	CHECK_EQUAL(RGBWWTrace::read(records, RGBWW_TRACE_SIZE, next), 0);
+	CHECK_EQUAL(next, first);
+
+	for (int i = 0; i < 10; i++) {
+		RGBWWTrace::record(RGBWW_TRACE_EVENT::TRACE_OUTPUT, i, 1, 2, 3, 4);
+	}
+	CHECK_EQUAL(RGBWWTrace::getCount(), 10);
+	CHECK_EQUAL(RGBWWTrace::read(records, 4, next), 4);
+	CHECK_EQUAL(next, first + 4);
+	CHECK_EQUAL(records[3].arg[0], 3);
+	CHECK_EQUAL(records[3].seq, first + 4);
+	CHECK_EQUAL(RGBWWTrace::read(records, RGBWW_TRACE_SIZE, next), 6);
+	CHECK_EQUAL(next, first + 10);
+	CHECK_EQUAL(records[0].arg[0], 4);
+	CHECK_EQUAL(records[5].event, RGBWW_TRACE_EVENT::TRACE_OUTPUT);
+	CHECK_EQUAL(RGBWWTrace::read(records, RGBWW_TRACE_SIZE, next), 0);
+}
+
+static void testOverwritten() {
+	uint32_t first = clearTrace();
+	RGBWWTraceRecord records[RGBWW_TRACE_SIZE];
+	for (int i = 0; i < RGBWW_TRACE_SIZE + 10; i++) {
+		RGBWWTrace::record(RGBWW_TRACE_EVENT::TRACE_PWM, i);
+	}
+	// the oldest 10 records are gone
+	uint32_t next = first;
+	CHECK_EQUAL(RGBWWTrace::read(records, RGBWW_TRACE_SIZE, next), RGBWW_TRACE_SIZE);
+	CHECK_EQUAL(records[0].arg[0], 10);
+	CHECK_EQUAL(next, first + RGBWW_TRACE_SIZE + 10);
+}
+
+static void testClear() {
+	uint32_t first = clearTrace();
+	RGBWWTraceRecord records[RGBWW_TRACE_SIZE];
+	for (int i = 0; i < 20; i++) {
+		RGBWWTrace::record(RGBWW_TRACE_EVENT::TRACE_PWM, i);
+	}
+	uint32_t next = first;
+	CHECK_EQUAL(RGBWWTrace::read(records, RGBWW_TRACE_SIZE, next), 20);
+
+	// clear() after the reader saved next
+	RGBWWTrace::clear();
+	CHECK_EQUAL(RGBWWTrace::getCount(), 0);
+	CHECK_EQUAL(RGBWWTrace::read(records, RGBWW_TRACE_SIZE, next), 0);
+	CHECK_EQUAL(next, first + 20);
+
+	RGBWWTrace::record(RGBWW_TRACE_EVENT::TRACE_OUTPUT, 100);
+	RGBWWTrace::record(RGBWW_TRACE_EVENT::TRACE_OUTPUT, 101);
+	CHECK_EQUAL(RGBWWTrace::read(records, RGBWW_TRACE_SIZE, next), 2);
+	CHECK_EQUAL(records[0].arg[0], 100);
+	CHECK_EQUAL(next, first + 22);
+
+	// more records written after the clear than were read before it
+	first = clearTrace();
+	for (int i = 0; i < 20; i++) {
+		RGBWWTrace::record(RGBWW_TRACE_EVENT::TRACE_PWM, i);
+	}
+	next = first;
+	CHECK_EQUAL(RGBWWTrace::read(records, RGBWW_TRACE_SIZE, next), 20);
+	RGBWWTrace::clear();
+	for (int i = 0; i < 25; i++) {
+		RGBWWTrace::record(RGBWW_TRACE_EVENT::TRACE_OUTPUT, 200 + i);
+	}
+	CHECK_EQUAL(RGBWWTrace::read(records, RGBWW_TRACE_SIZE, next), 25);
+	CHECK_EQUAL(records[0].arg[0], 200);
+	CHECK_EQUAL(records[24].arg[0], 224);
+
+	// a reader starting after the clear
+	next = 0;
+	CHECK_EQUAL(RGBWWTrace::read(records, RGBWW_TRACE_SIZE, next), 25);
+	CHECK_EQUAL(records[0].arg[0], 200);
+}
+
+
+int main() {
+	testRead();
+	testOverwritten();
+	testClear();
+	return checkResult();
+}
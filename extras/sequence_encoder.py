@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+RGBWWLed - encoder for binary frame sequences (see RGBWWLedSequence.h)
+
+Reads a csv file with one frame per line and one value per channel:
+
+    r,g,b,ww,cw
+    0,0,0,0,0
+    10,0,0,0,0
+    ...
+
+and writes a sequence file which can be played with RGBWWSequenceAnimation
+(lines starting with a letter or # are ignored)
+
+usage: sequence_encoder.py input.csv output.rwsq [--fps 50] [--depth 8]
+"""
+
+import argparse
+import struct
+import sys
+
+SKIP = 0x00
+DELTA = 0x40
+VALUE = 0x80
+MAXRUN = 64
+
+
+def read_frames(path):
+    frames = []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line or line[0] == '#' or line[0].isalpha():
+                continue
+            frames.append([int(v) for v in line.split(',')])
+    return frames
+
+
+def classify(previous, frame):
+    types = []
+    for old, new in zip(previous, frame):
+        delta = new - old
+        if delta == 0:
+            types.append(SKIP)
+        elif -128 <= delta <= 127:
+            types.append(DELTA)
+        else:
+            types.append(VALUE)
+    # a single unchanged channel between deltas is cheaper as delta 0
+    for i in range(1, len(types) - 1):
+        if types[i] == SKIP and types[i - 1] == DELTA and types[i + 1] == DELTA:
+            types[i] = DELTA
+    return types
+
+
+def encode_frame(previous, frame):
+    types = classify(previous, frame)
+    out = bytearray()
+    channel = 0
+    while channel < len(frame):
+        kind = types[channel]
+        count = 1
+        while (channel + count < len(frame) and types[channel + count] == kind
+               and count < MAXRUN):
+            count += 1
+        out.append(kind | (count - 1))
+        for i in range(channel, channel + count):
+            if kind == DELTA:
+                out += struct.pack('<b', frame[i] - previous[i])
+            elif kind == VALUE:
+                out += struct.pack('<H', frame[i])
+        channel += count
+    return out
+
+
+def encode(frames, fps, depth):
+    channels = len(frames[0]) if frames else 0
+    maxval = (1 << depth) - 1
+    out = bytearray(b'RWSQ')
+    out += struct.pack('<BBHHHI', 1, depth, channels, fps, 0, len(frames))
+    previous = [0] * channels
+    for number, frame in enumerate(frames):
+        if len(frame) != channels:
+            raise ValueError('frame %d has %d channels, expected %d' % (number, len(frame), channels))
+        if min(frame) < 0 or max(frame) > maxval:
+            raise ValueError('frame %d exceeds the range of %d bit' % (number, depth))
+        out += encode_frame(previous, frame)
+        previous = frame
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description='encode a csv light show into a RGBWWLed sequence')
+    parser.add_argument('input')
+    parser.add_argument('output')
+    parser.add_argument('--fps', type=int, default=50, help='frames per second (default 50)')
+    parser.add_argument('--depth', type=int, default=8, help='bits of the channel values (default 8)')
+    args = parser.parse_args()
+
+    frames = read_frames(args.input)
+    data = encode(frames, args.fps, args.depth)
+    with open(args.output, 'wb') as f:
+        f.write(data)
+    raw = len(frames) * (len(frames[0]) if frames else 0) * (1 if args.depth <= 8 else 2)
+    sys.stderr.write('%d frames, %d bytes (uncompressed %d bytes)\n' % (len(frames), len(data), raw))
+
+
+if __name__ == '__main__':
+    main()
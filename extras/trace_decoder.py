@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""
+RGBWWLed - decoder for binary trace records (see RGBWWLedTrace.h)
+
+Reads RGBWWTraceRecord structs (32 bytes each, little endian) as copied
+with RGBWWTrace::read() and sent by the application (i.e. over serial or
+udp) and prints one line per record. Records lost because the ring
+was overwritten before they were read are reported as gaps.
+
+usage: trace_decoder.py trace.bin [--relative]
+"""
+
+import argparse
+import struct
+import sys
+
+RECORD = struct.Struct('<IIHH5i')
+
+# RGBWW_TRACE_EVENT - name and argument names
+EVENTS = {
+    1: ('output', ('r', 'g', 'b', 'ww', 'cw')),
+    2: ('pwm', ('r', 'g', 'b', 'ww', 'cw')),
+    3: ('hsvtorgb', ('r', 'g', 'b', 'w')),
+    4: ('hsv.current', ('h', 's', 'v', 'ct')),
+    5: ('hsv.final', ('h', 's', 'v', 'ct')),
+    6: ('raw.current', ('r', 'g', 'b', 'ww', 'cw')),
+    7: ('raw.final', ('r', 'g', 'b', 'ww', 'cw')),
+    8: ('powerlimit', ('scale',)),
+}
+
+
+def read_records(data):
+    records = {}
+    for offset in range(0, len(data) - RECORD.size + 1, RECORD.size):
+        seq, time, event, _, *args = RECORD.unpack_from(data, offset)
+        if seq == 0:
+            continue
+        records[seq - 1] = (time, event, args)
+    return [(index,) + records[index] for index in sorted(records)]
+
+
+def format_record(event, args):
+    name, names = EVENTS.get(event, ('event%d' % event, ('a0', 'a1', 'a2', 'a3', 'a4')))
+    if event == 8:
+        # 16bit fixed point scale
+        return '%-12s scale=%.3f' % (name, args[0] / 65536.0)
+    return '%-12s ' % name + ' '.join('%s=%d' % (n, v) for n, v in zip(names, args))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='decode RGBWWLed binary trace records')
+    parser.add_argument('input', help='binary trace, - for stdin')
+    parser.add_argument('--relative', action='store_true', help='print times relative to the first record')
+    args = parser.parse_args()
+
+    if args.input == '-':
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, 'rb') as f:
+            data = f.read()
+
+    records = read_records(data)
+    start = records[0][1] if records and args.relative else 0
+    previous = None
+    lost = 0
+    for index, time, event, values in records:
+        if previous is not None and index != previous + 1:
+            print('--- %d records lost' % (index - previous - 1))
+            lost += index - previous - 1
+        print('%8d %10d %s' % (index, (time - start) & 0xFFFFFFFF, format_record(event, values)))
+        previous = index
+    sys.stderr.write('%d records, %d lost\n' % (len(records), lost))
+
+
+if __name__ == '__main__':
+    main()